@@ -1,11 +1,17 @@
 //
 // Created by Hamish Bultitude on 2019-09-19.
 //
-//#include "shared.h"
+#include "shared.h"
 
 #ifndef INC_2310HUB_2310ALICE_H
 #define INC_2310HUB_2310ALICE_H
 
+int alice_lead_move(const StrategyView *view);
 
+int alice_default_move(const StrategyView *view);
+
+int alice_choose(const StrategyView *view);
+
+extern const StrategyPlugin alicePlugin;
 
 #endif //INC_2310HUB_2310ALICE_H
@@ -0,0 +1,20 @@
+#include "shared.h"
+
+#ifndef INC_2310HUB_2310BOB_H
+#define INC_2310HUB_2310BOB_H
+
+int bob_lead_move(const StrategyView *view);
+
+int bob_d_card_move(const StrategyView *view);
+
+int bob_default_move(const StrategyView *view);
+
+int player_won_over_threshold(const StrategyView *view);
+
+int d_cards_in_round(const StrategyView *view);
+
+int bob_choose(const StrategyView *view);
+
+extern const StrategyPlugin bobPlugin;
+
+#endif //INC_2310HUB_2310BOB_H
@@ -0,0 +1,144 @@
+#include <pthread.h>
+#include "shared.h"
+#include "arena.h"
+
+#ifndef INC_2310HUB_2310CAROL_H
+#define INC_2310HUB_2310CAROL_H
+
+/*
+ * carol: information set Monte Carlo tree search. Before each move the cards
+ * carol has not seen are dealt at random to the other players, and one
+ * search tree over every player's moves is grown across many such deals,
+ * each player choosing what is best for its own final score. Each thread
+ * grows its own tree from its own random numbers, and carol plays the card
+ * visited most over all of them, so with a limit on iterations rather than
+ * time a move only depends on the seed and the position. Tuned through the
+ * environment:
+ *   CAROL_MS          milliseconds of search per move, 0 for no limit.
+ *   CAROL_ITERATIONS  iterations per thread per move, 0 for no limit.
+ *   CAROL_THREADS     search threads, one per core by default.
+ *   CAROL_SEED        seed of the searches, 0 by default.
+ */
+#define CAROL_MS_ENV "CAROL_MS"
+#define CAROL_ITERATIONS_ENV "CAROL_ITERATIONS"
+#define CAROL_THREADS_ENV "CAROL_THREADS"
+#define CAROL_SEED_ENV "CAROL_SEED"
+
+// search time per move when CAROL_MS is not set
+#define CAROL_DEFAULT_MS 20
+
+// most search threads
+#define CAROL_MAX_THREADS 64
+
+// bytes of search nodes each search thread can hold, the tree stops growing
+// after. Every seat carol plays from one thread shares the same arenas.
+#define CAROL_ARENA_SIZE (8 << 20)
+
+// weight of exploring moves tried less often, against their mean reward
+#define CAROL_EXPLORATION 0.7
+
+// struct for a node of a search tree, reached by one player playing a card
+typedef struct CarolNode {
+    struct CarolNode *parent;
+    struct CarolNode *child; // first of the moves after this one.
+    struct CarolNode *sibling; // next move from the same parent.
+    double reward; // sum of the mover's rewards over the visits.
+    uint32_t visits;
+    uint32_t available; // deals in which the move could have been played.
+    int mover; // player who played code.
+    uint8_t code;
+} CarolNode;
+
+// struct for a game being searched, with every array in one block
+typedef struct {
+    int playerCount;
+    int threshold;
+    int capacity; // most cards each player can hold.
+    int toMove;
+    int leadPlayer;
+    int leadSuit; // -1 until the lead card is played.
+    int played; // cards played this round.
+    int roundsLeft; // rounds after this one.
+    int over; // 1 once the last round is done.
+    size_t size; // bytes in block.
+    char *block;
+    int *counts; // [player] cards held.
+    int *nScore; // [player] rounds won.
+    int *dScore; // [player] D cards won.
+    uint8_t *roundCards; // [player] code played this round.
+    uint8_t *cards; // [player * capacity + i] codes held.
+} CarolGame;
+
+struct CarolState;
+
+// struct for one search thread, its tree and its copy of the game
+typedef struct {
+    struct CarolState *carol;
+    pthread_t thread;
+    Arena nodes; // the game copies then the tree, reset every move.
+    CarolGame game;
+    CarolNode *root;
+    uint8_t *pool; // the unseen codes, shuffled a little by every deal.
+    uint64_t stream; // random numbers of this thread for this move.
+    uint64_t counter;
+    uint32_t *marks; // [code] stamp of the codes held by the mover.
+    uint32_t *tried; // [code] stamp of the codes with a child.
+    uint32_t stamp;
+    double *rewards; // [player] reward of the deal just played out.
+    long iterations;
+} CarolSearch;
+
+// struct for what carol keeps about one seat between moves
+typedef struct CarolState {
+    int playerCount;
+    int myID;
+    int threshold;
+    int ms;
+    long iterations;
+    int threads;
+    uint64_t seed;
+    uint64_t position; // hash of what carol sees, picks the random numbers.
+    int lastHandSize; // 0 before the first move of a game.
+    int lastDBefore; // D cards played before the round of the last move.
+    int *nScore; // [player] rounds won this game, from who leads next.
+    int *dScore; // [player] D cards won this game.
+    CarolGame root; // the game as carol sees it, other hands empty.
+    size_t rootRoom; // bytes allocated for root's block.
+    uint8_t *unseen; // codes which may be in the other players' hands.
+    int unseenCount;
+    int unseenSize;
+    int maxRank; // highest rank seen, used to make up missing cards.
+    uint64_t deadline; // monotonic time the search must end by, 0 if none.
+    CarolSearch *searches; // [threads] shared with the thread's other seats.
+} CarolState;
+
+void *carol_open(int playerCount, int myID, int threshold);
+
+void carol_close(void *state);
+
+int carol_choose(const StrategyView *view);
+
+void carol_track_scores(CarolState *carol, const StrategyView *view);
+
+int carol_see_game(CarolState *carol, const StrategyView *view);
+
+uint64_t carol_position(const StrategyView *view);
+
+size_t carol_game_size(int playerCount, int capacity);
+
+void carol_game_place(CarolGame *game, int playerCount, int capacity,
+        void *block);
+
+void carol_game_copy(CarolGame *to, const CarolGame *from);
+
+void carol_game_play(CarolGame *game, uint8_t code);
+
+void carol_deal(CarolSearch *search);
+
+void carol_iterate(CarolSearch *search);
+
+void *carol_search(void *arg);
+
+extern const StrategyPlugin carolPlugin;
+
+#endif //INC_2310HUB_2310CAROL_H
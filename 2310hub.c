@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // close_range
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -12,21 +13,79 @@
 #include <fcntl.h>
 #include "2310hub.h"
 #include <limits.h>
+#include <getopt.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/signalfd.h>
+#include <stdarg.h>
+#include <stdio_ext.h>
+#include <sys/stat.h>
+#include <spawn.h>
+#include <sys/pidfd.h>
+#include <sys/epoll.h>
+#include "plugin.h"
+#include "2310alice.h"
+#include "2310bob.h"
+#include "2310carol.h"
 
-// global struct for SIGHUP signal.
-SighupVars sighupStruct;
+extern char **environ;
 
+// players the hub plays itself when it is run as them
+static const BuiltinPlayer builtinPlayers[] = {
+    {"2310alice", &alicePlugin},
+    {"2310bob", &bobPlugin},
+    {"2310carol", &carolPlugin}
+};
 
 /**
- * Function called via SIGHUP signal (through sigaction) to signal the signal's
- * arrival.
- * @param s - integer representing the signal received.
+ * Function to find the built-in player a program name refers to. 2310alice
+ * and 2310bob are links to the hub, which plays them when run by their name.
+ * @param name - program name or path, only the last component is used.
+ * @return the player's strategy, NULL if it is not a built-in player.
  */
-void handle_sighup(int s) {
-    sighupStruct.sighup = true;
-    end_process(sighupStruct.pidChildren, sighupStruct.players,
-            sighupStruct.playerCount);
-    exit(show_message(GOTSIGHUP));
+const StrategyPlugin *builtin_player(const char *name) {
+    const char *base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    for (size_t i = 0; i < sizeof(builtinPlayers) / sizeof(*builtinPlayers);
+            i++) {
+        if (strcmp(base, builtinPlayers[i].name) == 0) {
+            return builtinPlayers[i].plugin;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Function to check if a player path would run this hub as a built-in
+ * player, so the forked child can play it without exec. Other programs of
+ * the same name are run as usual.
+ * @param path - player path from the command line.
+ * @return the player's strategy, NULL if the path must be run.
+ */
+const StrategyPlugin *builtin_path(const char *path) {
+    const StrategyPlugin *plugin = builtin_player(path);
+    struct stat player, self;
+    if (!plugin || access(path, X_OK) || stat(path, &player)
+            || stat("/proc/self/exe", &self)
+            || player.st_dev != self.st_dev || player.st_ino != self.st_ino) {
+        return NULL;
+    }
+    return plugin;
+}
+
+/**
+ * Function to block SIGHUP and create a descriptor which becomes readable when
+ * it arrives, so it can be waited on with the players' pipes.
+ * @return the signalfd, or -1 on failure.
+ */
+int setup_sighup(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    if (sigprocmask(SIG_BLOCK, &mask, 0) != 0) {
+        return -1;
+    }
+    return signalfd(-1, &mask, SFD_CLOEXEC);
 }
 
 /**
@@ -44,7 +103,9 @@ Status show_message(Status s) {
             "Player EOF\n",
             "Invalid message\n",
             "Invalid card choice\n",
-            "Ended due to signal\n"};
+            "Ended due to signal\n",
+            "Player timeout\n",
+            "Log error\n"};
     fputs(messages[s], stderr);
     return s;
 }
@@ -78,6 +139,18 @@ void arg_creator(Game *game, char **argv, char **args, int i) {
     args[5] = 0;
 }
 
+/**
+ * Function to find how many cards each player is dealt from a deck. Cards
+ * left over once every player has the same number are not dealt.
+ * @param deck - deck to deal.
+ * @param playerCount - number of players.
+ * @return cards for each player, at most HAND_MAX.
+ */
+int deal_hand_size(const Deck *deck, int playerCount) {
+    int handSize = deck->count / playerCount;
+    return handSize < HAND_MAX ? handSize : HAND_MAX;
+}
+
 /**
  * Function to setup variables for players of the game.
  * @param game struct representing hub's tracking of game.
@@ -85,133 +158,1326 @@ void arg_creator(Game *game, char **argv, char **args, int i) {
 void allocate_player_memory(Game *game) {
     // allocate memory to all values that will be used.
     game->pidChildren = malloc(game->playerCount * sizeof(int));
+    game->pidFds = malloc(game->playerCount * sizeof(int));
+    for (int i = 0; i < game->playerCount; i++) {
+        game->pidChildren[i] = -1;
+        game->pidFds[i] = -1;
+    }
+    game->started = 0;
+    game->endDeadline = 0;
     game->players = malloc(game->playerCount * sizeof(Player));
-    game->numCardsToDeal = floor((game->deck.count / game->playerCount));
+    game->numCardsToDeal = deal_hand_size(&game->source, game->playerCount);
+    engine_init(&game->engine, game->playerCount, game->threshold);
+    game->moveTimes = game->timing
+            ? calloc(game->playerCount, sizeof(Histogram)) : NULL;
+}
+
+/**
+ * Function to close players when exiting.
+ * @param game struct representing hub's tracking of game.
+ */
+void close_players(Game *game) {
+    for (int i = 0; i < game->playerCount; i++) {
+        Player *player = &game->players[i];
+        if (player->binary) {
+            reserve_output(player, 1);
+            player->output[player->outputLength++] = WIRE_GAMEOVER;
+        } else {
+            queue_message(player, "GAMEOVER\n");
+        }
+    }
+    flush_players(game);
+}
+
+/**
+ * Function to make sure a player's output buffer can take more bytes. The
+ * buffer is reused for every message so it only grows, never per message.
+ * @param player - player whose buffer to grow.
+ * @param extra - number of bytes about to be added.
+ */
+void reserve_output(Player *player, int extra) {
+    if (player->outputLength + extra > player->outputSize) {
+        while (player->outputLength + extra > player->outputSize) {
+            player->outputSize *= 2;
+        }
+        player->output = realloc(player->output, player->outputSize);
+    }
+}
+
+/**
+ * Function to add a formatted message to a player's output buffer, tagged with
+ * its table if the player is multiplexed. Nothing is written until the player
+ * is flushed.
+ * @param player - player to send the message to.
+ * @param format - printf style format of the message.
+ */
+void queue_message(Player *player, const char *format, ...) {
+    if (player->tag >= 0) {
+        // lines to multiplexed players say which table they are for
+        reserve_output(player, 12);
+        player->outputLength += sprintf(player->output + player->outputLength,
+                "%d:", player->tag);
+    }
+    va_list args;
+    va_start(args, format);
+    int space = player->outputSize - player->outputLength;
+    int length = vsnprintf(player->output + player->outputLength, space,
+            format, args);
+    va_end(args);
+    if (length >= space) {
+        // did not fit, grow and format again
+        reserve_output(player, length + 1);
+        va_start(args, format);
+        vsnprintf(player->output + player->outputLength,
+                player->outputSize - player->outputLength, format, args);
+        va_end(args);
+    }
+    player->outputLength += length;
+}
+
+/**
+ * Function to write everything queued for a player with a single write.
+ * @param player - player to flush.
+ * @return 0 - all written (or nothing queued)
+ *         6 - the player's pipe is closed.
+ */
+int flush_player(Player *player) {
+    if (player->shm) {
+        return flush_ring(player);
+    }
+    int written = 0;
+    while (written < player->outputLength) {
+        ssize_t count = write(player->pipeIn[1], player->output + written,
+                player->outputLength - written);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            player->outputLength = 0;
+            return PLAYEREOF;
+        }
+        written += count;
+    }
+    player->outputLength = 0;
+    return OK;
+}
+
+/**
+ * Function to write everything queued for a player to its ring, waiting for
+ * space if the player has fallen behind.
+ * @param player - player to flush.
+ * @return 0 - all written (or nothing queued)
+ *         6 - the player has gone.
+ */
+int flush_ring(Player *player) {
+    Ring *ring = &player->link->toPlayer;
+    int written = 0;
+    while (written < player->outputLength) {
+        written += ring_put(ring, player->output + written,
+                player->outputLength - written);
+        if (written < player->outputLength && !ring_wait_writable(ring,
+                player->link->spin, RING_SLICE_MS) && player_hung_up(player)) {
+            player->outputLength = 0;
+            return PLAYEREOF;
+        }
+    }
+    player->outputLength = 0;
+    return OK;
+}
+
+/**
+ * Function to flush every player with queued messages.
+ * @param game struct representing hub's tracking of game.
+ * @return 0 - all written
+ *         6 - a player's pipe is closed.
+ */
+int flush_players(Game *game) {
+    int status = OK;
+    for (int i = 0; i < game->playerCount; i++) {
+        if (flush_player(&game->players[i]) != OK) {
+            status = PLAYEREOF;
+        }
+    }
+    return status;
+}
+
+/**
+ * Function to tell a player which protocols it is offered, through the
+ * environment it is started with.
+ * @param game struct representing hub's tracking of game.
+ * @param player - player being started.
+ * @param shmFd - descriptor of its shared memory segment, -1 if none.
+ */
+void offer_protocols(Game *game, Player *player, int shmFd) {
+    // offer the binary protocol, players accept it with "@B"
+    if (game->binary) {
+        setenv(WIRE_ENV, "binary", 1);
+    } else {
+        unsetenv(WIRE_ENV);
+    }
+    // offer multiplexing, players accept it with "@M"
+    if (game->mux) {
+        setenv(MUX_ENV, "1", 1);
+    } else {
+        unsetenv(MUX_ENV);
+    }
+    if (player->link) {
+        char fd[12];
+        sprintf(fd, "%d", shmFd);
+        setenv(SHM_ENV, fd, 1);
+    } else {
+        unsetenv(SHM_ENV);
+    }
+}
+
+/**
+ * Function to start a built-in player or plug-in in a forked child, which
+ * plays it without running a program.
+ * @param game struct representing hub's tracking of game.
+ * @param player - player being started.
+ * @param args - arguments for the player, args[0] naming it.
+ * @param builtin - strategy of a built-in player, NULL for a plug-in.
+ * @param shmFd - descriptor of its shared memory segment, -1 if none.
+ * @return pid of the child, -1 if fork failed.
+ */
+pid_t fork_player(Game *game, Player *player, char **args,
+        const StrategyPlugin *builtin, int shmFd) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    close(player->pipeIn[1]); // for child - close write end.
+    close(player->pipeOut[0]); // for child - close read end.
+    //send pipeA stuff to stdin of child.
+    dup2(player->pipeIn[0], STDIN_FILENO);
+    //send stdout child to write of pipeB
+    dup2(player->pipeOut[1], STDOUT_FILENO);
+    int dir = open("/dev/null", O_WRONLY);
+    dup2(dir, 2); // supress stderr of child
+    // without an exec nothing is closed for us, and the hub's descriptors
+    // would keep other players' pipes from reaching EOF, so keep only the
+    // standard ones and the shared memory
+    int keep = shmFd > STDERR_FILENO ? shmFd : STDERR_FILENO;
+    if (keep > STDERR_FILENO + 1) {
+        close_range(STDERR_FILENO + 1, keep - 1, 0);
+    }
+    close_range(keep + 1, ~0U, 0);
+    // SIGHUP is blocked in the hub, give the child the default mask.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, 0);
+    signal(SIGPIPE, SIG_DFL);
+    offer_protocols(game, player, shmFd);
+    const StrategyPlugin *plugin = builtin ? builtin : plugin_load(args[0]);
+    if (!plugin) {
+        exit(show_message(PLAYERSTART));
+    }
+    __fpurge(stdin); // read ahead from the hub's stdin
+    exit(run_player(5, args, plugin));
+}
+
+/**
+ * Function to start a player program with posix_spawn, which does not copy
+ * the hub's page tables as fork does, so starting many players is cheap.
+ * @param game struct representing hub's tracking of game.
+ * @param player - player being started.
+ * @param args - arguments for the player, args[0] being the program.
+ * @param shmFd - descriptor of its shared memory segment, -1 if none.
+ * @return pid of the child, -1 if the program could not be run.
+ */
+pid_t spawn_player(Game *game, Player *player, char **args, int shmFd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, player->pipeIn[0],
+            STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, player->pipeOut[1],
+            STDOUT_FILENO);
+    // supress stderr of child
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+            O_WRONLY, 0);
+    // SIGHUP is blocked and SIGPIPE ignored in the hub, the child gets the
+    // default mask and SIGPIPE back.
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t mask, defaults;
+    sigemptyset(&mask);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(&attributes, &mask);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    posix_spawnattr_setflags(&attributes,
+            POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    // the hub never reads these, so its own environment is passed on
+    offer_protocols(game, player, shmFd);
+    pid_t pid;
+    int error = posix_spawn(&pid, args[0], &actions, &attributes, args,
+            environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    return error ? -1 : pid;
+}
+
+/**
+ * Function to start every player. No player is waited for, check_players
+ * then waits for all of their handshakes at once.
+ * @param game struct representing hub's tracking of game.
+ * @param argv arguments from command line.
+ * @return 0 - no errors
+ *         5 - error starting the players
+ */
+int create_players(Game *game, char **argv) {
+    allocate_player_memory(game);
+    // children get copies of our buffers, which must not be written twice
+    fflush(NULL);
+
+    for (int i = 0; i < game->playerCount; i++) {
+        Player *player = &game->players[i];
+        // create pipes for communication, which programs only keep as their
+        // stdin and stdout
+        player->pipeIn = malloc(sizeof(int) * 2);
+        player->pipeOut = malloc(sizeof(int) * 2);
+        pipe(player->pipeIn);
+        pipe(player->pipeOut);
+        for (int end = 0; end < 2; end++) {
+            fcntl(player->pipeIn[end], F_SETFD, FD_CLOEXEC);
+            fcntl(player->pipeOut[end], F_SETFD, FD_CLOEXEC);
+        }
+        // offer shared memory, players accept it with "S"
+        int shmFd = -1;
+        player->link = game->shm ? shm_create(game->spin, &shmFd) : NULL;
+        char *args[6];
+        arg_creator(game, argv, args, i);
+        // built-in players and plug-ins are played by a forked child
+        const StrategyPlugin *builtin = builtin_path(argv[i + 3]);
+        pid_t pid = builtin || is_plugin(argv[i + 3])
+                ? fork_player(game, player, args, builtin, shmFd)
+                : spawn_player(game, player, args, shmFd);
+        for (int arg = 1; arg < 5; arg++) {
+            free(args[arg]);
+        }
+        // end_process closes the hub's ends, even if there is no child
+        game->started = i + 1;
+        game->pidChildren[i] = pid;
+        close(player->pipeIn[0]); //close unnecessary pipes
+        close(player->pipeOut[1]);
+        if (shmFd >= 0) {
+            close(shmFd); // the mapping stays
+        }
+        if (pid < 0) {
+            return show_message(PLAYERSTART);
+        }
+        watch_player_exits(game, i);
+    }
+
+    for (int i = 0; i < game->playerCount; i++) {
+        // set up buffers for communication.
+        game->players[i].outputSize = 256;
+        game->players[i].output = malloc(game->players[i].outputSize);
+        game->players[i].outputLength = 0;
+        game->players[i].inputLength = 0;
+        game->players[i].tag = -1;
+        game->players[i].shm = 0;
+    }
+    return OK;
+}
+
+/**
+ * Function to wait for every player's handshake at once, so starting the
+ * players takes as long as the slowest one rather than all of them, then
+ * check each starts with "@".
+ * @param game struct representing hub's tracking of game.
+ * @return 0 if ok
+ *         5 if player cannot be found.
+ *         9 - received SIGHUP
+ *         10 - a player took longer than --start-timeout.
+ */
+int check_players(Game *game) {
+    uint64_t deadline = game->startTimeout ? timing_now()
+            + (uint64_t) game->startTimeout * 1000000 : 0;
+    struct pollfd fds[game->playerCount + 2];
+    int waiting = 0;
+    for (int i = 0; i < game->playerCount; i++) {
+        // a negative descriptor is skipped by poll
+        Player *player = &game->players[i];
+        fds[i].fd = player->inputLength == 0 ? player->pipeOut[0] : -1;
+        fds[i].events = POLLIN;
+        waiting += fds[i].fd >= 0;
+    }
+    watch_hub_events(game, &fds[game->playerCount]);
+    while (waiting > 0) {
+        int ready = poll(fds, game->playerCount + 2, deadline_left(deadline));
+        if (ready < 0 && errno != EINTR) {
+            return show_message(PLAYERSTART);
+        } else if (ready == 0) {
+            return PLAYERTIMEOUT;
+        } else if (ready < 0) {
+            continue;
+        }
+        if (fds[game->playerCount].revents & POLLIN) {
+            return GOTSIGHUP;
+        } else if (fds[game->playerCount + 1].revents
+                && !input_ready(fds, game->playerCount)) {
+            return show_message(PLAYERSTART); // a player has exited
+        }
+        for (int i = 0; i < game->playerCount; i++) {
+            if (fds[i].fd < 0 || !fds[i].revents) {
+                continue;
+            }
+            if (read_player_input(&game->players[i]) != OK) {
+                return show_message(PLAYERSTART);
+            }
+            fds[i].fd = -1;
+            waiting--;
+        }
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        Player *player = &game->players[i];
+        if (player->input[0] != '@') {
+            return show_message(PLAYERSTART);
+        }
+        // "@B" accepts the binary protocol, if it was offered.
+        int handshake = 1;
+        player->binary = game->binary && player->inputLength > 1
+                && player->input[1] == 'B';
+        // "@M" accepts multiplexing, which a multiplexed hub requires.
+        if (game->mux && (player->inputLength < 2 || player->input[1] != 'M')) {
+            return show_message(PLAYERSTART);
+        }
+        if (player->binary || game->mux) {
+            handshake++;
+        }
+        // "S" after that accepts the shared memory rings, if they were offered
+        player->shm = player->link && player->inputLength > handshake
+                && player->input[handshake] == 'S';
+        if (player->shm) {
+            handshake++;
+        }
+        // consume the handshake so only protocol messages remain.
+        player->inputLength -= handshake;
+        memmove(player->input, player->input + handshake,
+                player->inputLength);
+    }
+    return show_message(OK);
+}
+
+/**
+ * Function to wait until the given player has written more bytes and add them
+ * to its input buffer. Every other player is watched for hanging up, every
+ * process for exiting and SIGHUP through the signalfd, so the hub only wakes
+ * when there is something to do.
+ * At a table of a multi-table hub the event loop does the reading instead.
+ * @param game struct representing hub's tracking of game.
+ * @param id - ID of the player expected to write.
+ * @return 0 - more input is available
+ *         6 - a player closed its pipe or the read failed
+ *         7 - the player's message is too long to buffer
+ *         9 - received SIGHUP
+ *         10 - the move or game deadline passed first
+ *         -2 - the table must wait for the event loop
+ */
+int fill_player_input(Game *game, int id) {
+    Player *player = &game->players[id];
+    if (game->multiplexed) {
+        return WAITING;
+    }
+    if (player->inputLength == PLAYER_INPUT_SIZE) {
+        return PLAYERMSG;
+    } else if (player->shm) {
+        return fill_ring_input(game, id);
+    }
+    struct pollfd fds[game->playerCount + 2];
+    for (int i = 0; i < game->playerCount; i++) {
+        fds[i].fd = game->players[i].pipeOut[0];
+        // others are only watched for hangups (always reported by poll)
+        fds[i].events = (i == id) ? POLLIN : 0;
+    }
+    watch_hub_events(game, &fds[game->playerCount]);
+
+    int ready;
+    while ((ready = poll(fds, game->playerCount + 2, time_left(game))) < 0) {
+        if (errno != EINTR) {
+            return PLAYEREOF;
+        }
+    }
+    if (ready == 0) {
+        return PLAYERTIMEOUT;
+    }
+    if (fds[game->playerCount].revents & POLLIN) {
+        return GOTSIGHUP;
+    } else if (fds[game->playerCount + 1].revents
+            && !input_ready(fds, game->playerCount)) {
+        return PLAYEREOF; // a player has exited
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        if (i != id && fds[i].revents & (POLLHUP | POLLERR)) {
+            return PLAYEREOF;
+        }
+    }
+    return read_player_input(player);
+}
+
+/**
+ * Function to add the bytes a player has written to its input buffer, once
+ * poll has said they are there.
+ * @param player - player to read from.
+ * @return 0 - more input is available
+ *         6 - the player closed its pipe or the read failed
+ *         7 - the player's message is too long to buffer
+ */
+int read_player_input(Player *player) {
+    if (player->inputLength == PLAYER_INPUT_SIZE) {
+        return PLAYERMSG;
+    }
+    ssize_t got = read(player->pipeOut[0], player->input + player->inputLength,
+            PLAYER_INPUT_SIZE - player->inputLength);
+    if (got <= 0) {
+        return PLAYEREOF;
+    }
+    player->inputLength += got;
+    return OK;
+}
+
+/**
+ * Function to wait until the given player has written more bytes to its ring
+ * and add them to its input buffer. The wait spins and then sleeps on the
+ * ring a slice at a time. What poll would have woken the hub for is checked
+ * once a slice, whether or not the hub has been waiting.
+ * @param game struct representing hub's tracking of game.
+ * @param id - ID of the player expected to write.
+ * @return 0 - more input is available
+ *         6 - a player has gone
+ *         9 - received SIGHUP
+ *         10 - the move or game deadline passed first.
+ */
+int fill_ring_input(Game *game, int id) {
+    Player *player = &game->players[id];
+    Ring *ring = &player->link->fromPlayer;
+    while (1) {
+        uint64_t now = timing_now();
+        if (now - game->lastWatch >= RING_SLICE_MS * 1000000ULL) {
+            game->lastWatch = now;
+            int status = watch_players(game);
+            if (status != OK) {
+                return status;
+            }
+        }
+        int left = time_left(game);
+        if (left == 0) {
+            return PLAYERTIMEOUT;
+        }
+        int slice = left < 0 || left > RING_SLICE_MS ? RING_SLICE_MS : left;
+        if (ring_wait_readable(ring, game->spin, slice)) {
+            break;
+        }
+    }
+    player->inputLength += ring_get(ring, player->input + player->inputLength,
+            PLAYER_INPUT_SIZE - player->inputLength);
+    return OK;
+}
+
+/**
+ * Function to check, without waiting, for SIGHUP and for players which have
+ * exited or closed their pipes.
+ * @param game struct representing hub's tracking of game.
+ * @return 0 - nothing has happened
+ *         6 - a player has gone
+ *         9 - received SIGHUP.
+ */
+int watch_players(Game *game) {
+    struct pollfd fds[game->playerCount + 2];
+    for (int i = 0; i < game->playerCount; i++) {
+        fds[i].fd = game->players[i].pipeOut[0];
+        fds[i].events = 0;
+    }
+    watch_hub_events(game, &fds[game->playerCount]);
+    if (poll(fds, game->playerCount + 2, 0) <= 0) {
+        return OK; // interrupted polls are tried again after the next slice
+    }
+    if (fds[game->playerCount].revents & POLLIN) {
+        return GOTSIGHUP;
+    } else if (fds[game->playerCount + 1].revents) {
+        return PLAYEREOF; // a player has exited
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        if (fds[i].revents & (POLLHUP | POLLERR)) {
+            return PLAYEREOF;
+        }
+    }
+    return OK;
+}
+
+/**
+ * Function to fill the two descriptors every wait for players watches after
+ * their pipes: the SIGHUP signalfd, then the epoll of their pidfds.
+ * @param game struct representing hub's tracking of game.
+ * @param fds - the two entries to fill.
+ */
+void watch_hub_events(Game *game, struct pollfd *fds) {
+    fds[0].fd = game->signalFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = game->exitFd;
+    fds[1].events = POLLIN;
+}
+
+/**
+ * Function to check if poll found input on a pipe it was asked to read. A
+ * player which wrote before exiting is read before its exit is acted on.
+ * @param fds - the players' pipes as given to poll.
+ * @param count - number of pipes.
+ * @return 1 if one has input, 0 if not.
+ */
+int input_ready(struct pollfd *fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (fds[i].fd >= 0 && fds[i].events & POLLIN && fds[i].revents) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to check, without waiting, if a player has closed its pipe.
+ * @param player - player to check.
+ * @return 1 if it has, 0 if not.
+ */
+int player_hung_up(Player *player) {
+    struct pollfd fd = {player->pipeOut[0], 0, 0};
+    return poll(&fd, 1, 0) > 0 && fd.revents & (POLLHUP | POLLERR);
+}
+
+/**
+ * Function to find how long the hub can wait for a player before the move or
+ * game deadline passes.
+ * @param game struct representing hub's tracking of game.
+ * @return milliseconds left (rounded up), 0 if a deadline has passed, -1 if
+ *         there is no deadline.
+ */
+int time_left(Game *game) {
+    uint64_t deadline = game->moveDeadline;
+    if (game->gameDeadline && (!deadline || game->gameDeadline < deadline)) {
+        deadline = game->gameDeadline;
+    }
+    return deadline_left(deadline);
+}
+
+/**
+ * Function to find how long poll can wait before a deadline passes.
+ * @param deadline - monotonic time in nanoseconds, 0 for no deadline.
+ * @return milliseconds left (rounded up), 0 if the deadline has passed, -1 if
+ *         there is no deadline.
+ */
+int deadline_left(uint64_t deadline) {
+    if (!deadline) {
+        return -1;
+    }
+    uint64_t now = timing_now();
+    if (now >= deadline) {
+        return 0;
+    }
+    uint64_t left = (deadline - now + 999999) / 1000000;
+    return left < INT_MAX ? left : INT_MAX;
+}
+
+/**
+ * Function to remove the first complete line from a player's input buffer.
+ * @param player - player to take the line from.
+ * @param line - buffer to copy the line (with its newline) into.
+ * @param size - size of the line buffer.
+ * @return length of the line
+ *         0 if no complete line has arrived yet
+ *         -1 if the line does not fit in the buffer.
+ */
+int take_player_line(Player *player, char *line, int size) {
+    char *newline = memchr(player->input, '\n', player->inputLength);
+    if (!newline) {
+        return 0;
+    }
+    int length = newline - player->input + 1;
+    if (length >= size) {
+        return -1;
+    }
+    memcpy(line, player->input, length);
+    line[length] = '\0';
+    player->inputLength -= length;
+    memmove(player->input, newline + 1, player->inputLength);
+    return length;
+}
+
+/**
+ * Function to handle the creation of a game (or series of games).
+ * @param argc - number of command line args
+ * @param argv - arguments supplied on command line.
+ * @param options - options parsed from before the deck argument.
+ * @return 0 - normal exit after game
+ *         3 - error parsing deck
+ *         4 - less than P cards in deck.
+ *         5 - error starting player
+ *         6 - EOF from player
+ *         7 - invalid player message
+ *         8 - invalid card choice from player
+ *         9 - received SIGHUP signal.
+ *         10 - a player ran out of time
+ *         11 - the log could not be opened.
+ */
+int new_game(int argc, char **argv, HubOptions *options) {
+    Game game;
+    game.games = options->games;
+    game.binary = options->binary;
+    game.packed = options->deckPack != NULL;
+    game.seeded = options->deckSpec != NULL;
+    game.seed = options->seed;
+    game.timing = options->timing;
+    game.moveTimeout = options->moveTimeout;
+    game.gameTimeout = options->gameTimeout;
+    game.startTimeout = options->startTimeout;
+    game.moveDeadline = 0;
+    game.gameDeadline = 0;
+    game.results = stdout;
+    game.multiplexed = 0;
+    game.awaiting = 0;
+    game.mux = options->mux;
+    game.tableId = 0;
+    game.log = NULL;
+    game.shm = options->shm;
+    game.spin = options->spin;
+    game.lastWatch = 0;
+    memset(game.phaseTimes, 0, sizeof(game.phaseTimes));
+    game.signalFd = setup_sighup();
+    game.exitFd = epoll_create1(EPOLL_CLOEXEC);
+    // a closed player pipe is reported by write, not by killing the hub.
+    signal(SIGPIPE, SIG_IGN);
+    // parse arguments from command line
+    int parseStatus = parse(argc, argv, &game);
+    if (parseStatus != 0) {
+        return parseStatus;
+    }
+    if (options->log && open_log(&game, options->log) != OK) {
+        return show_message(LOGERROR);
+    }
+    if (options->tables > 1 || options->mux) {
+        return play_tables(&game, options->tables, argv);
+    }
+
+    // attempt to create players, any started are ended if one fails.
+    int createStatus = create_players(&game, argv);
+    if (createStatus != 0) {
+        end_process(&game);
+        return createStatus;
+    }
+
+    // check that players have loaded.
+    int playerStatus = check_players(&game);
+    if (playerStatus != 0) {
+        end_process(&game);
+        return playerStatus == GOTSIGHUP || playerStatus == PLAYERTIMEOUT
+                ? show_message(playerStatus) : playerStatus;
+    }
+
+    // play every game with the same set of player processes.
+    int status = play_games(&game);
+    if (status != 0) {
+        // end the children processes, a slow player may never exit.
+        end_process(&game);
+    }
+    return show_message(status);
+}
+
+/**
+ * Function to play each game of a tournament, reusing the player processes.
+ * Players are told to reset with NEWGAME between games and are sent GAMEOVER
+ * once the final game has finished.
+ * @param game struct representing hub's tracking of game.
+ * @return 0 - all games completed
+ *         otherwise the status of the game which failed.
+ */
+int play_games(Game *game) {
+    for (game->gameNumber = 0; game->gameNumber < game->games;
+            game->gameNumber++) {
+        if (game->gameNumber > 0) {
+            int dealStatus = game->packed || game->seeded
+                    ? next_deal(game) : OK;
+            if (dealStatus < 0) {
+                break; // a streamed pack has run out of deals
+            } else if (dealStatus != OK) {
+                close_players(game);
+                end_process(game);
+                return dealStatus;
+            }
+            queue_newgame(game);
+        }
+        start_next_game(game);
+        int status = game_loop(game);
+        if (status != OK) {
+            return status;
+        }
+        log_game(game);
+        if (game->timing && (game->gameNumber + 1) % TIMING_REPORT_GAMES == 0
+                && game->gameNumber + 1 < game->games) {
+            print_timing(game, game->gameNumber + 1);
+        }
+    }
+
+    // all games are done, send gameover and kill children processes
+    close_players(game);
+    end_process(game);
+    if (game->timing) {
+        print_timing(game, game->gameNumber);
+    }
+    engine_free(&game->engine);
+    if (game->packed) {
+        deckpack_close(game->pack);
+    }
+    if (game->log) {
+        fclose(game->log);
+    }
+    return OK;
+}
+
+/**
+ * Function to have the players reset their state for another deal.
+ * @param game struct representing hub's tracking of game.
+ */
+void queue_newgame(Game *game) {
+    for (int i = 0; i < game->playerCount; i++) {
+        if (game->players[i].binary) {
+            queue_record(&game->players[i], WIRE_NEWGAME,
+                    game->numCardsToDeal);
+        } else {
+            queue_message(&game->players[i], "NEWGAME%d\n",
+                    game->numCardsToDeal);
+        }
+    }
+}
+
+/**
+ * Function to play the games of a tournament on several tables at once. Each
+ * table has its own players, deal and state, and one poll watches every
+ * player so whichever table can go on next does. A table takes the next game
+ * number each time it finishes a game and prints that game's results in one
+ * piece, headed by its game number.
+ * @param first - game set up by parse, which every table starts as a copy of.
+ * @param tableCount - number of tables wanted.
+ * @param argv - arguments from the command line, naming the players.
+ * @return 0 - all games completed
+ *         otherwise the status of the table which failed.
+ */
+int play_tables(Game *first, int tableCount, char **argv) {
+    Tables all;
+    int count = tableCount < first->games ? tableCount : first->games;
+    // Table is a whole number of cache lines, so tables never share one
+    void *tables;
+    if (posix_memalign(&tables, HUB_CACHE_LINE, count * sizeof(Table))) {
+        return show_message(PLAYERSTART);
+    }
+    all.tables = tables;
+    all.fds = malloc((count * first->playerCount + 2)
+            * sizeof(struct pollfd));
+    all.count = 0;
+    all.open = 0;
+    all.nextGame = 0;
+    all.played = 0;
+    all.mux = first->mux;
+    all.seats = NULL;
+
+    // start every table's players before any game begins
+    int status = OK;
+    while (all.count < count && status == OK) {
+        status = open_table(&all, first, &all.tables[all.count].game, argv);
+    }
+    if (status > 0) {
+        end_tables(&all);
+        return status; // already shown
+    }
+    status = OK;
+    for (int t = 0; t < all.count && status == OK; t++) {
+        start_next_game(&all.tables[t].game);
+        status = step_table(&all, &all.tables[t].game);
+    }
+    while (status == OK && all.open > 0) {
+        status = poll_tables(&all);
+    }
+    end_tables(&all);
+    if (status == OK && first->timing) {
+        print_table_timing(&all);
+    }
+    for (int t = 0; t < all.count; t++) {
+        fclose(all.tables[t].game.results);
+        free(all.tables[t].game.resultsText);
+        engine_free(&all.tables[t].game.engine);
+    }
+    if (first->packed) {
+        deckpack_close(first->pack);
+    }
+    if (first->log) {
+        fclose(first->log);
+    }
+    free(all.fds);
+    free(all.tables);
+    free(all.seats);
+    return show_message(status);
+}
+
+/**
+ * Function to set up a table: load its first deal and start and check its
+ * players. The first table plays the deal parse loaded. When multiplexed the
+ * first table's players serve the other tables too.
+ * @param all - every table of the hub.
+ * @param first - game set up by parse.
+ * @param table - table to set up.
+ * @param argv - arguments from the command line, naming the players.
+ * @return 0 - the table is ready
+ *         -1 - there are no deals left for it
+ *         otherwise the error, which has been shown.
+ */
+int open_table(Tables *all, Game *first, Game *table, char **argv) {
+    *table = *first;
+    if (all->nextGame > 0 && (first->seeded || first->packed)) {
+        table->source.contents = malloc(sizeof(Card)
+                * (first->seeded ? dealgen_shoe_size(&first->deal)
+                : DECKPACK_MAX_CARDS));
+        table->gameNumber = all->nextGame;
+        int dealStatus = next_deal(table);
+        if (dealStatus != OK) {
+            return dealStatus < 0 ? dealStatus : show_message(dealStatus);
+        }
+    }
+    table->gameNumber = all->nextGame++;
+    table->closed = 0;
+    table->tableId = all->count;
+    if (all->mux && all->count > 0) {
+        share_players(table, &all->tables[0].game, all->count);
+        all->count++;
+        all->open++;
+    } else {
+        // counted first, so end_tables ends whichever players were started
+        all->count++;
+        all->open++;
+        int status = create_players(table, argv);
+        if (status != OK) {
+            return status;
+        }
+        status = check_players(table);
+        if (status == GOTSIGHUP || status == PLAYERTIMEOUT) {
+            return show_message(status);
+        } else if (status != OK) {
+            return status;
+        }
+    }
+    if (all->mux && all->count == 1) {
+        // the processes read and write untagged lines through these
+        all->seats = malloc(table->playerCount * sizeof(Player));
+        for (int i = 0; i < table->playerCount; i++) {
+            all->seats[i] = table->players[i];
+            all->seats[i].inputLength = 0;
+            table->players[i].tag = 0;
+        }
+    }
+    table->multiplexed = 1;
+    table->results = open_memstream(&table->resultsText,
+            &table->resultsLength);
+    table->tableGames = 1;
+    return OK;
+}
+
+/**
+ * Function to give a table the next game, or close it if none are left.
+ * @param all - every table of the hub.
+ * @param table - table which has finished a game.
+ * @return 0 - the next game has started
+ *         -1 - no games were left, the table's players have been told
+ *         3 - the deal is invalid
+ *         4 - less than P cards in the deal.
+ */
+int next_table_game(Tables *all, Game *table) {
+    int dealStatus = -1;
+    if (all->nextGame < table->games) {
+        table->gameNumber = all->nextGame;
+        dealStatus = table->packed || table->seeded ? next_deal(table) : OK;
+    }
+    if (dealStatus < 0) {
+        close_players(table);
+        // multiplexed processes still have other tables to serve. Others are
+        // reaped by poll_tables as they exit, so no table waits for them.
+        if (!all->mux) {
+            release_players(table);
+        }
+        table->closed = 1;
+        all->open--;
+        return -1;
+    } else if (dealStatus != OK) {
+        return dealStatus;
+    }
+    all->nextGame++;
+    table->tableGames++;
+    queue_newgame(table);
+    start_next_game(table);
+    return OK;
+}
+
+/**
+ * Function to play a table's games until it has to wait for a player, or
+ * has no games left.
+ * @param all - every table of the hub.
+ * @param table - table to play.
+ * @return 0 - the table is waiting or closed
+ *         otherwise the status of the game which failed.
+ */
+int step_table(Tables *all, Game *table) {
+    int status;
+    while ((status = game_loop(table)) == OK) {
+        log_game(table);
+        // tables finish in any order, so each game is printed whole
+        fflush(table->results);
+        printf("Game %d\n", table->gameNumber);
+        fwrite(table->resultsText, 1, table->resultsLength, stdout);
+        fflush(stdout);
+        rewind(table->results);
+        all->played++;
+        if (table->timing && all->played % TIMING_REPORT_GAMES == 0
+                && all->played < table->games) {
+            print_table_timing(all);
+        }
+        status = next_table_game(all, table);
+        if (status != OK) {
+            return status < 0 ? OK : status;
+        }
+    }
+    return status == WAITING ? OK : status;
+}
+
+/**
+ * Function to wait until the player to move at any table has written, or a
+ * deadline passes, then play on at each table which got input.
+ * @param all - every table of the hub.
+ * @return 0 - tables played on
+ *         6 - a player closed its pipe or the read failed
+ *         7 - a player's message is too long to buffer
+ *         9 - received SIGHUP
+ *         10 - a move or game deadline passed
+ *         otherwise the status of a game which failed.
+ */
+int poll_tables(Tables *all) {
+    if (all->mux) {
+        return poll_mux(all);
+    }
+    int count = 0;
+    int timeout = -1;
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (table->closed) {
+            continue;
+        }
+        for (int i = 0; i < table->playerCount; i++) {
+            all->fds[count].fd = table->players[i].pipeOut[0];
+            // others are only watched for hangups (always reported by poll)
+            all->fds[count].events = i == table->engine.toMove ? POLLIN : 0;
+            count++;
+        }
+        int left = time_left(table);
+        if (left >= 0 && (timeout < 0 || left < timeout)) {
+            timeout = left;
+        }
+    }
+    for (int t = 0; t < all->count; t++) {
+        uint64_t end = all->tables[t].game.endDeadline;
+        int left = end ? deadline_left(end) : -1;
+        if (left >= 0 && (timeout < 0 || left < timeout)) {
+            timeout = left;
+        }
+    }
+    watch_hub_events(&all->tables[0].game, &all->fds[count]);
+
+    while (poll(all->fds, count + 2, timeout) < 0) {
+        if (errno != EINTR) {
+            return PLAYEREOF;
+        }
+    }
+    reap_tables(all);
+    if (all->fds[count].revents & POLLIN) {
+        return GOTSIGHUP;
+    } else if (all->fds[count + 1].revents && !input_ready(all->fds, count)
+            && table_player_exited(all)) {
+        return PLAYEREOF; // a player has exited
+    }
+    struct pollfd *fd = all->fds;
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (table->closed) {
+            continue;
+        }
+        int ready = 0;
+        for (int i = 0; i < table->playerCount; i++, fd++) {
+            if (fd->events & POLLIN && fd->revents) {
+                int status = read_player_input(&table->players[i]);
+                if (status != OK) {
+                    return status;
+                }
+                ready = 1;
+            } else if (fd->revents & (POLLHUP | POLLERR)) {
+                return PLAYEREOF;
+            }
+        }
+        if (ready) {
+            int status = step_table(all, table);
+            if (status != OK) {
+                return status;
+            }
+        } else if (time_left(table) == 0) {
+            return PLAYERTIMEOUT;
+        }
+    }
+    return OK;
+}
+
+/**
+ * Function to print the response and phase times of every table together.
+ * @param all - every table of the hub.
+ */
+void print_table_timing(Tables *all) {
+    Game merged = all->tables[0].game;
+    merged.moveTimes = calloc(merged.playerCount, sizeof(Histogram));
+    memset(merged.phaseTimes, 0, sizeof(merged.phaseTimes));
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        for (int i = 0; i < table->playerCount; i++) {
+            histogram_merge(&merged.moveTimes[i], &table->moveTimes[i]);
+        }
+        for (int i = 0; i < HUB_PHASES; i++) {
+            histogram_merge(&merged.phaseTimes[i], &table->phaseTimes[i]);
+        }
+    }
+    print_timing(&merged, all->played);
+    free(merged.moveTimes);
+}
+
+/**
+ * Function to reap the players of tables which have ended as they exit,
+ * killing those still running once their table's grace period is over.
+ * @param all - every table of the hub.
+ */
+void reap_tables(Tables *all) {
+    uint64_t now = timing_now();
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (table->endDeadline
+                && !reap_players(table, now >= table->endDeadline)) {
+            table->endDeadline = 0;
+        }
+    }
+}
+
+/**
+ * Function to check the pidFd events of every table for a player which has
+ * exited while its table is still playing. Players of tables which have
+ * ended exit as they are expected to, and are reaped instead. Events not
+ * taken this time are still readable, so the next poll returns at once.
+ * @param all - every table of the hub.
+ * @return 1 if a player of a playing table has exited, 0 if not.
+ */
+int table_player_exited(Tables *all) {
+    struct epoll_event events[HUB_EXIT_EVENTS];
+    int count = epoll_wait(all->tables[0].game.exitFd, events,
+            HUB_EXIT_EVENTS, 0);
+    int ended = 0;
+    for (int i = 0; i < count; i++) {
+        Game *table = &all->tables[events[i].data.u64 >> 32].game;
+        if (!table->closed && !table->endDeadline) {
+            return 1;
+        }
+        ended = 1;
+    }
+    // reaping takes their pidFds out of the epoll
+    if (ended) {
+        reap_tables(all);
+    }
+    return 0;
+}
+
+/**
+ * Function to end the players of every table, waiting for those still
+ * running. Every table's players are asked to exit before any are waited
+ * for, so they all get the same grace period.
+ * @param all - every table of the hub.
+ */
+void end_tables(Tables *all) {
+    for (int t = 0; t < all->count; t++) {
+        // multiplexed processes belong to the first table
+        if (!all->mux || t == 0) {
+            release_players(&all->tables[t].game);
+        }
+    }
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (!all->mux || t == 0) {
+            end_process(table);
+        }
+        table->closed = 1;
+    }
+    all->open = 0;
+}
+
+/**
+ * Function to seat a table at the first table's multiplexed player
+ * processes. The table has its own buffers, and its lines are tagged with its
+ * number so the processes know which of their games each is for.
+ * @param table - table to seat.
+ * @param owner - first table, which started the processes.
+ * @param tag - number of the table.
+ */
+void share_players(Game *table, Game *owner, int tag) {
+    allocate_player_memory(table);
+    for (int i = 0; i < table->playerCount; i++) {
+        Player *player = &table->players[i];
+        *player = owner->players[i];
+        player->outputSize = 256;
+        player->output = malloc(player->outputSize);
+        player->outputLength = 0;
+        player->inputLength = 0;
+        player->tag = tag;
+        table->pidChildren[i] = owner->pidChildren[i];
+    }
+}
+
+/**
+ * Function to wait until a multiplexed seat with a table waiting on it has
+ * written, or a deadline passes, then pass each line to its table.
+ * @param all - every table of the hub.
+ * @return 0 - tables played on
+ *         6 - a player closed its pipe or the read failed
+ *         7 - a player's message is too long or for no open table
+ *         9 - received SIGHUP
+ *         10 - a move or game deadline passed
+ *         otherwise the status of a game which failed.
+ */
+int poll_mux(Tables *all) {
+    int seats = all->tables[0].game.playerCount;
+    int timeout = -1;
+    for (int i = 0; i < seats; i++) {
+        all->fds[i].fd = all->seats[i].pipeOut[0];
+        all->fds[i].events = 0;
+    }
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (table->closed) {
+            continue;
+        }
+        all->fds[table->engine.toMove].events = POLLIN;
+        int left = time_left(table);
+        if (left >= 0 && (timeout < 0 || left < timeout)) {
+            timeout = left;
+        }
+    }
+    watch_hub_events(&all->tables[0].game, &all->fds[seats]);
+
+    while (poll(all->fds, seats + 2, timeout) < 0) {
+        if (errno != EINTR) {
+            return PLAYEREOF;
+        }
+    }
+    if (all->fds[seats].revents & POLLIN) {
+        return GOTSIGHUP;
+    } else if (all->fds[seats + 1].revents && !input_ready(all->fds, seats)) {
+        return PLAYEREOF; // a player has exited
+    }
+    for (int i = 0; i < seats; i++) {
+        if (all->fds[i].events & POLLIN && all->fds[i].revents) {
+            int status = read_player_input(&all->seats[i]);
+            if (status == OK) {
+                status = route_mux_input(all, i);
+            }
+            if (status != OK) {
+                return status;
+            }
+        } else if (all->fds[i].revents & (POLLHUP | POLLERR)) {
+            return PLAYEREOF;
+        }
+    }
+    for (int t = 0; t < all->count; t++) {
+        Game *table = &all->tables[t].game;
+        if (!table->closed && time_left(table) == 0) {
+            return PLAYERTIMEOUT;
+        }
+    }
+    return OK;
 }
 
 /**
- * Function to close players when exiting.
- * @param game struct representing hub's tracking of game.
+ * Function to pass each whole line a multiplexed seat has sent to the table
+ * it is tagged for, without the tag, and play on at that table.
+ * @param all - every table of the hub.
+ * @param seat - seat whose process has written.
+ * @return 0 - every line was passed on
+ *         7 - a line is too long or not for an open table
+ *         otherwise the status of a game which failed.
  */
-void close_players(Game *game) {
-    for (int i = 0; i < game->playerCount; i++) {
-        fprintf(game->players[i].fileIn, "GAMEOVER\n");
-        fflush(game->players[i].fileIn);
+int route_mux_input(Tables *all, int seat) {
+    char line[PLAYER_INPUT_SIZE];
+    int length;
+    while ((length = take_player_line(&all->seats[seat], line,
+            sizeof(line))) != 0) {
+        char *message;
+        long tag = length < 0 ? -1 : strtol(line, &message, 10);
+        if (tag < 0 || tag >= all->count || message == line
+                || *message != ':' || all->tables[tag].game.closed) {
+            return PLAYERMSG;
+        }
+        Player *player = &all->tables[tag].game.players[seat];
+        int size = length - (message + 1 - line);
+        if (player->inputLength + size > PLAYER_INPUT_SIZE) {
+            return PLAYERMSG;
+        }
+        memcpy(player->input + player->inputLength, message + 1, size);
+        player->inputLength += size;
+        int status = step_table(all, &all->tables[tag].game);
+        if (status != OK) {
+            return status;
+        }
     }
+    return OK;
 }
 
 /**
- * Function to perform forking of players
+ * Function to open the game log, appending to it if it already exists.
  * @param game struct representing hub's tracking of game.
- * @param argv arguments from command line.
- * @return 0 - no errors
- *         5 - error starting the players
+ * @param name - file name of the log.
+ * @return 0 if the log is open, 11 if it could not be opened.
  */
-int create_players(Game *game, char **argv) {
-    allocate_player_memory(game);
-
-    // fork current process and exec child to give player processes.
-    for (int i = 0; i < game->playerCount; i++) {
-        // create pipes for communication
-        game->players[i].pipeIn = malloc(sizeof(int) * 2);
-        game->players[i].pipeOut = malloc(sizeof(int) * 2);
-        pipe(game->players[i].pipeIn);
-        pipe(game->players[i].pipeOut);
-        pid_t pid;
-        if ((pid = fork()) < 0) {
-            return show_message(PLAYERSTART); // pipe failed.
-        } else if (pid == 0) {
-            // child
-            close(game->players[i].pipeIn[1]); // for child - close write end.
-            close(game->players[i].pipeOut[0]); // for child - close read end.
-            //send pipeA stuff to stdin of child.
-            dup2(game->players[i].pipeIn[0], STDIN_FILENO);
-            //send stdout child to write of pipeB
-            dup2(game->players[i].pipeOut[1], STDOUT_FILENO);
-            int dir = open("/dev/null", O_WRONLY);
-            dup2(dir, 2); // supress stderr of child
-            char *args[6];
-            // create args and exec
-            arg_creator(game, argv, args, i);
-            execv(argv[i + 3], args);
-            // if failed, return and show player start error.
-            return show_message(PLAYERSTART);
-        } else {
-            // parent
-            game->pidChildren[i] = pid;
-            game->players[i].size = game->numCardsToDeal;
-            close(game->players[i].pipeIn[0]); //close unnecessary pipes
-            close(game->players[i].pipeOut[1]);
-        }
+int open_log(Game *game, const char *name) {
+    game->log = fopen(name, "abe");
+    if (!game->log) {
+        return LOGERROR;
+    }
+    // a new log starts with its header, an old one already has it
+    fseek(game->log, 0, SEEK_END);
+    if (ftell(game->log) == 0) {
+        gamelog_write_header(game->log);
     }
-
-    for (int i = 0; i < game->playerCount; i++) {
-        // create file pointers for easier communication.
-        game->players[i].fileIn = fdopen(game->players[i].pipeIn[1], "w");
-        game->players[i].fileOut = fdopen(game->players[i].pipeOut[0], "r");
-    }
-    // store children for signal removal.
-    sighupStruct.pidChildren = game->pidChildren;
-    sighupStruct.players = game->players;
-    sighupStruct.playerCount = game->playerCount;
     return OK;
 }
 
 /**
- * Function to go through each player and read to check if we get "@"
+ * Function to append the game just finished to the game log, if there is one.
  * @param game struct representing hub's tracking of game.
- * @return 0 if ok
- *         5 if player cannot be found.
  */
-int check_players(Game *game) {
-    for (int i = 0; i < game->playerCount; i++) {
-        // read first character to see if appropriate @ symbol present.
-        char c = fgetc(game->players[i].fileOut);
-        if (c != '@') {
-            return show_message(PLAYERSTART);
-        }
+void log_game(Game *game) {
+    if (game->log) {
+        gamelog_write_game(game->log, game->gameNumber, &game->engine,
+                game->source.contents);
     }
-    return show_message(OK);
 }
 
 /**
- * Function to handle the creation of a game.
- * @param argc - number of command line args
- * @param argv - arguments supplied on command line.
- * @return 0 - normal exit after game
- *         3 - error parsing deck
- *         4 - less than P cards in deck.
- *         5 - error starting player
- *         6 - EOF from player
- *         7 - invalid player message
- *         8 - invalid card choice from player
- *         9 - received SIGHUP signal.
+ * Function to deal the loaded deck to the engine and set up the state for the
+ * next game, starting its time budget if there is one.
+ * @param game struct representing hub's tracking of game.
  */
-int new_game(int argc, char **argv) {
-    Game game;
-    game.firstRound = 1;
-    game.leadPlayer = 0;
-    // parse arguments from command line
-    int parseStatus = parse(argc, argv, &game);
-    if (parseStatus != 0) {
-        return parseStatus;
-    }
-
-    // attempt to create players
-    int createStatus = create_players(&game, argv);
-    if (createStatus != 0) {
-        return createStatus;
+void start_next_game(Game *game) {
+    engine_deal(&game->engine, game->source.contents, game->numCardsToDeal);
+    if (game->gameTimeout) {
+        game->gameDeadline = timing_now()
+                + (uint64_t) game->gameTimeout * 1000000;
     }
-
-    // check that players have loaded.
-    int playerStatus = check_players(&game);
-    if (playerStatus != 0) {
-        return playerStatus;
-    }
-
-    // set up initial variables and begin the game. 
-    init_state(&game);
-    return show_message(game_loop(&game));
+    init_state(game);
 }
 
 /**
@@ -222,48 +1488,31 @@ int new_game(int argc, char **argv) {
  * @return 0 when done.
  */
 int deal_card_to_player(Game *game, int id) {
-    Card cardsForPlayer[game->numCardsToDeal];
-    int j;
-    // take cards from deck and place in player's hand
-    for (j = 0; j < game->numCardsToDeal; j++) {
-        cardsForPlayer[j] = game->deck.contents[j];
-        game->playerHands[id][j] = game->deck.contents[j];
-    }
-
-    // remove the cards we just took.
-    for (j = 0; j < game->numCardsToDeal; j++) {
-        remove_deck_card(game, &cardsForPlayer[j]);
-    }
+    // the engine deals from the front of the deck, one hand after another.
+    Card *cardsForPlayer = game->source.contents + id * game->numCardsToDeal;
+    Player *player = &game->players[id];
 
-    // create msg to send to player process.
+    // create msg to send to player process, straight into its buffer.
     int cardNo = game->numCardsToDeal;
-    char *hand = malloc((4 + number_digits(cardNo) + cardNo + (cardNo * 2) + 2)
-            * sizeof(char));
-    strcpy(hand, "HAND");
-    char insertNumber[cardNo];
-    sprintf(insertNumber, "%d", cardNo);
-    int i;
-    for (i = 4; i < (number_digits(cardNo) + 4); i++) {
-        hand[i] = insertNumber[i - 4];
-    }
-    int pos = 0;
-    for (i = i; i < (cardNo + (cardNo * 2) + number_digits(cardNo) + 3); i++) {
-        if ((i - (4 + number_digits(cardNo))) % 3 == 0) {
-            // comma
-            hand[i] = ',';
-        } else {
-            // card
-            hand[i] = cardsForPlayer[pos].suit;
-            hand[++i] = cardsForPlayer[pos].rank;
-            pos++;
-        }
-    }
-    hand[i] = '\n';
-    hand[i + 1] = '\0';
-    // send the msg to the player!
-    game->playerHandSizes[id] = game->numCardsToDeal;
-    fprintf(game->players[id].fileIn, hand);
-    fflush(game->players[id].fileIn);
+    if (player->binary) {
+        queue_record(player, WIRE_HAND, cardNo);
+        reserve_output(player, cardNo);
+        for (int i = 0; i < cardNo; i++) {
+            player->output[player->outputLength++]
+                    = card_to_wire(cardsForPlayer[i]);
+        }
+        return DONE;
+    }
+    queue_message(player, "HAND%d", cardNo);
+    reserve_output(player, cardNo * (CARD_TEXT_SIZE + 1) + 1);
+    char *hand = player->output + player->outputLength;
+    int length = 0;
+    for (int i = 0; i < cardNo; i++) {
+        hand[length++] = ',';
+        length += card_to_text(cardsForPlayer[i], hand + length);
+    }
+    hand[length++] = '\n';
+    player->outputLength += length;
     return DONE;
 }
 
@@ -275,72 +1524,24 @@ void newround_msg(Game *game) {
     // send appropraite new round message
     if (game->firstRound) {
         for (int i = 0; i < game->playerCount; i++) {
-            fprintf(game->players[i].fileIn, "NEWROUND%d\n", game->leadPlayer);
-            fflush(game->players[i].fileIn);
+            if (game->players[i].binary) {
+                queue_record(&game->players[i], WIRE_NEWROUND,
+                        game->engine.leadPlayer);
+            } else {
+                queue_message(&game->players[i], "NEWROUND%d\n",
+                        game->engine.leadPlayer);
+            }
         }
     }
     // calculate the appropriate last player to move
-    if (game->leadPlayer != 0) {
-        game->lastPlayer = game->leadPlayer - 1;
+    if (game->engine.leadPlayer != 0) {
+        game->lastPlayer = game->engine.leadPlayer - 1;
     } else {
         game->lastPlayer = game->playerCount - 1;
     }
     next_state(game);
 }
 
-/**
- * Function to handle the calculation of scores at the end of each round.
- * @param game struct representing hub's tracking of game.
- */
-void calculate_scores(Game *game) {
-    int rank = 0;
-    int winner = -1;
-    int dCardCount = 0;
-    // calculate number of D cards played
-    for (int i = 0; i < game->playerCount; i++) {
-        Card playedCard = game->cardsByRound[game->roundNumber][i];
-        if (playedCard.suit == 'D') {
-            dCardCount++;
-        }
-        // find the winner of the round based on highest
-        if (game->leadSuit == playedCard.suit) {
-            if (get_rank_integer(playedCard.rank) >= rank) {
-                rank = get_rank_integer(playedCard.rank);
-                winner = i;
-            }
-        }
-    }
-    // allocate score to the winner
-    game->leadPlayer = winner;
-    game->nScore[winner] += 1;
-    game->dScore[winner] += dCardCount;
-}
-
-/**
- * Function to remove card from players hand
- * @param game struct representing hub's tracking of game.
- * @param card struct of card to remove
- * @param player int representing player to remove from
- */
-void remove_card_hand(Game *game, Card *card, int player) {
-    int pos = 0;
-    // find position of card played.
-    for (int i = 0; i < game->playerHandSizes[player]; i++) {
-        if (game->playerHands[player][i].suit == card->suit) {
-            if (game->playerHands[player][i].rank == card->rank) {
-                pos = i;
-                break;
-            }
-        }
-    }
-    for (int q = pos; q < game->playerHandSizes[player] - 1; q++) {
-        // shift all cards to compensate for removal.
-        game->playerHands[player][q] = game->playerHands[player][q + 1];
-    }
-
-    game->playerHandSizes[player] -= 1;
-}
-
 /**
  * Function to check if a card is present in the player's hand.
  * @param game struct representing hub's tracking of game.
@@ -350,20 +1551,9 @@ void remove_card_hand(Game *game, Card *card, int player) {
  *         8 if card not present.
  */
 int check_card_in_hand(Game *game, Card *card, int player) {
-    int found = 0;
-    // set found to 1 if card was present
-    for (int i = 0; i < game->playerHandSizes[player]; i++) {
-        if (card->suit == game->playerHands[player][i].suit) {
-            if (card->rank == game->playerHands[player][i].rank) {
-                found = 1;
-            }
-        }
-    }
-    // if card not found, show error msg, otherwise remove the card
-    if (found != 1) {
+    // if card not found, show error msg, the engine removes it when played
+    if (!engine_holds(&game->engine, player, *card)) {
         return show_message(PLAYERCHOICE);
-    } else {
-        remove_card_hand(game, card, player);
     }
     return OK;
 }
@@ -373,92 +1563,164 @@ int check_card_in_hand(Game *game, Card *card, int player) {
  * @param game struct representing hub's tracking of game.
  * @param message string message from player
  * @param player int representing player to validate
- * @return
+ * @param newCard struct to fill with the card played
+ * @return 0 if the play is valid
+ *         7 if the message is invalid
+ *         8 if the card is not in the player's hand.
  */
-int validate_play(Game *game, char *message, int player) {
-    if (strncmp(message, "PLAY", 4) != 0) {
+int validate_play(Game *game, char *message, int player, Card *newCard) {
+    if (message_type(message) != MSG_PLAY) {
         close_players(game);
         return show_message(PLAYERMSG);
     }
-    if (strlen(message) != 7) {
-        close_players(game);
-        return show_message(PLAYERMSG);
-    }
-
-    // check card is proper format
-    Card newCard;
-    if (validate_card(message[4]) && (isdigit(message[5]) ||
-            (isalpha(message[5]) && isxdigit(message[5])
-            && islower(message[5])))) {
-        newCard.suit = message[4];
-        newCard.rank = message[5];
-    } else {
+    // check card is proper format and ends the line
+    int length = text_to_card(message + 4, newCard);
+    if (length == 0 || strcmp(message + 4 + length, "\n") != 0) {
         close_players(game);
         return show_message(PLAYERMSG);
     }
 
     // check that the card is in players hand
-    int checked = check_card_in_hand(game, &newCard, player);
+    int checked = check_card_in_hand(game, newCard, player);
     if (checked != 0) {
         return checked;
     }
     return OK;
 }
 
+/**
+ * Function to wait for the move of a player and validate it, in whichever
+ * protocol the player agreed to.
+ * @param game struct representing hub's tracking of game.
+ * @param player int representing player to move
+ * @param card struct to fill with the card played
+ * @return 0 if a valid card was played
+ *         6 if the player closed its pipe
+ *         7 if the message is invalid
+ *         8 if the card is not in the player's hand.
+ *         9 if SIGHUP was received
+ *         10 if the player ran out of time
+ *         -2 if the table must wait for the move, call again once it arrives
+ */
+int receive_play(Game *game, int player, Card *card) {
+    Player *mover = &game->players[player];
+    if (!game->awaiting) {
+        // the player to move gets everything queued for it in one write, the
+        // others wait until their own turn (or the end of the game).
+        if (flush_player(mover) != OK) {
+            return PLAYEREOF;
+        }
+        if (game->moveTimeout) {
+            game->moveDeadline = timing_now()
+                    + (uint64_t) game->moveTimeout * 1000000;
+        }
+        game->turnStart = game->timing ? timing_now() : 0;
+        game->awaiting = 1;
+    }
+    if (mover->binary) {
+        // fixed size record, no parsing needed
+        while (mover->inputLength < 2) {
+            int status = fill_player_input(game, player);
+            if (status != OK) {
+                return status;
+            }
+        }
+        game->awaiting = 0;
+        unsigned char *record = (unsigned char *) mover->input;
+        int valid = record[0] == WIRE_PLAY;
+        *card = wire_to_card(record[1]);
+        mover->inputLength -= 2;
+        memmove(mover->input, mover->input + 2, mover->inputLength);
+        if (!valid) {
+            close_players(game);
+            return show_message(PLAYERMSG);
+        }
+        return check_card_in_hand(game, card, player);
+    }
+
+    const short bufferSize = (short) log10(INT_MAX) + 3;
+    char buffer[bufferSize];
+    // wait until the player to move has sent a whole line
+    int length;
+    while ((length = take_player_line(mover, buffer, bufferSize)) == 0) {
+        int status = fill_player_input(game, player);
+        if (status != OK) {
+            return status;
+        }
+    }
+    game->awaiting = 0;
+    if (length < 0) {
+        close_players(game);
+        return PLAYERMSG;
+    }
+    // check player message
+    return validate_play(game, buffer, player, card);
+}
+
+/**
+ * Function to queue a binary record made of a type and a 16 bit number.
+ * @param player - player to send the record to.
+ * @param type - record type, one of the WIRE_ values.
+ * @param number - number following the type.
+ */
+void queue_record(Player *player, int type, int number) {
+    reserve_output(player, 3);
+    unsigned char *record = (unsigned char *) player->output
+            + player->outputLength;
+    record[0] = type;
+    record[1] = number & 0xFF;
+    record[2] = (number >> 8) & 0xFF;
+    player->outputLength += 3;
+}
+
+/**
+ * Function to queue the message telling a player another player's move.
+ * @param player - player to tell.
+ * @param id - ID of the player who moved.
+ * @param card - card they played.
+ */
+void queue_played(Player *player, int id, Card card) {
+    if (player->binary) {
+        queue_record(player, WIRE_PLAYED, id);
+        reserve_output(player, 1);
+        player->output[player->outputLength++] = card_to_wire(card);
+    } else {
+        char text[CARD_TEXT_SIZE];
+        queue_message(player, "PLAYED%d,%.*s\n", id,
+                card_to_text(card, text), text);
+    }
+}
+
 /**
  * Function to handle the sending of messages to the players, along with the
  * reception of messages too from said players.
  * @param game struct representing hub's tracking of game.
  * @return 0 when complete
+ *         otherwise the status from receive_play.
  */
 int send_and_receive(Game *game) {
-    // set current player
-    int playerMove = game->leadPlayer;
-    bool go = true;
-    int numberPlays = 0;
-    while (go) {
-        const short bufferSize = (short) log10(INT_MAX) + 3;
-        char buffer[bufferSize];
-        // attempt to read from fgets
-        if (!fgets(buffer, bufferSize - 1, game->players[playerMove].fileOut)
-                || feof(game->players[playerMove].fileOut)
-                || ferror(game->players[playerMove].fileOut)) {
-            return show_message(PLAYEREOF);
-        }
-        // check player message
-        int validation = validate_play(game, buffer, playerMove);
+    // the engine tracks whose turn it is until everyone has played, so a
+    // table which had to wait carries on from the same player.
+    int playerMove = game->engine.toMove;
+    EngineStatus status = ENGINE_OK;
+    while (status == ENGINE_OK) {
+        Card playedCard;
+        int validation = receive_play(game, playerMove, &playedCard);
         if (validation != 0) {
             return validation;
         }
-        if (playerMove == game->leadPlayer) {
-            game->leadSuit = buffer[4];
+        if (game->timing) {
+            histogram_record(&game->moveTimes[playerMove],
+                    timing_now() - game->turnStart);
         }
-        // store cards
-        Card playedCard;
-        playedCard.suit = buffer[4];
-        playedCard.rank = buffer[5];
-        game->cardsByRound[game->roundNumber][playerMove] = playedCard;
-        game->cardsOrderPlayed[game->roundNumber][numberPlays] = playedCard;
-        // send move to other players
-        char *playedMsg = malloc(7 + number_digits(playerMove) + 2);
-        sprintf(playedMsg, "%s%d,%c%c\n", "PLAYED", playerMove, buffer[4],
-                buffer[5]);
+        status = engine_play(&game->engine, playerMove, playedCard);
+        // queue move for other players
         for (int i = 0; i < game->playerCount; i++) {
             if (i != playerMove) {
-                fprintf(game->players[i].fileIn, playedMsg);
-                fflush(game->players[i].fileIn);
-            }
-        }
-        playerMove += 1; // move to next player
-        numberPlays += 1;
-        if (numberPlays == game->playerCount) {
-            go = false;
-            break;
-        } else if (numberPlays != game->playerCount) {
-            if (playerMove == game->playerCount) {
-                playerMove = 0;
+                queue_played(&game->players[i], playerMove, playedCard);
             }
         }
+        playerMove = game->engine.toMove;
     }
     return DONE;
 }
@@ -469,19 +1731,22 @@ int send_and_receive(Game *game) {
  * @param game struct representing hub's tracking of game.
  */
 void end_round_output(Game *game) {
-    printf("Lead player=%d\n", game->leadPlayer);
-    printf("Cards=");
+    // the engine has already moved past the round that just finished
+    int round = game->engine.roundNumber - 1;
+    Card *cards = game->engine.cardsOrderPlayed + round * game->playerCount;
+    FILE *results = game->results;
+    fprintf(results, "Lead player=%d\n", game->engine.leadByRound[round]);
+    fprintf(results, "Cards=");
     // place cards into stdin
     for (int i = 0; i < game->playerCount; i++) {
-        Card playedCard = game->cardsOrderPlayed[game->roundNumber][i];
+        Card playedCard = cards[i];
         if (i < game->playerCount - 1) {
-            printf("%c.%c ", playedCard.suit, playedCard.rank);
+            fprintf(results, "%c.%x ", playedCard.suit, playedCard.rank);
         } else {
-            printf("%c.%c", playedCard.suit, playedCard.rank);
+            fprintf(results, "%c.%x", playedCard.suit, playedCard.rank);
         }
     }
-    printf("\n");
-    calculate_scores(game);
+    fprintf(results, "\n");
 }
 
 /**
@@ -490,99 +1755,212 @@ void end_round_output(Game *game) {
  * @param game struct representing hub's tracking of game.
  */
 void end_game_output(Game *game) {
-    // calculate the final scores based on whether they reached threshold.
-    for (int i = 0; i < game->playerCount; i++) {
-        if (game->dScore[i] >= game->threshold) {
-            game->finalScores[i] = game->nScore[i] + game->dScore[i];
-        } else {
-            game->finalScores[i] = game->nScore[i] - game->dScore[i];
-        }
-    }
-    // display the scores of each player.
+    // display the scores of each player, calculated by the engine.
+    int *finalScores = game->engine.finalScores;
+    FILE *results = game->results;
     for (int i = 0; i < game->playerCount; i++) {
         if (i != game->playerCount - 1) {
-            printf("%d:%d ", i, game->finalScores[i]);
+            fprintf(results, "%d:%d ", i, finalScores[i]);
         } else {
-            printf("%d:%d", i, game->finalScores[i]);
+            fprintf(results, "%d:%d", i, finalScores[i]);
         }
     }
-    printf("\n");
+    fprintf(results, "\n");
+    fflush(results);
+}
 
-    // send gameover to players
+/**
+ * Function to print the response time of each player and the time spent in
+ * each phase so far, to stderr so the game output is unchanged.
+ * @param game struct representing hub's tracking of game.
+ * @param played - number of games played so far.
+ */
+void print_timing(Game *game, int played) {
+    const char *phases[HUB_PHASES] = {"deal", "newround", "endround"};
+    char label[32];
+    fprintf(stderr, "timing after %d games\n%-10s %10s %10s %10s %10s\n",
+            played, "(us)", "count", "p50", "p99", "max");
     for (int i = 0; i < game->playerCount; i++) {
-        fprintf(game->players[i].fileIn, "GAMEOVER\n");
-        fflush(game->players[i].fileIn);
+        sprintf(label, "player %d", i);
+        histogram_print(stderr, label, &game->moveTimes[i]);
+    }
+    for (int i = 0; i < HUB_PHASES; i++) {
+        histogram_print(stderr, phases[i], &game->phaseTimes[i]);
+    }
+}
+
+/**
+ * Function to watch a player's process, so a player which dies is noticed
+ * by any wait for players, not only when its pipe is next read.
+ * @param game struct representing hub's tracking of game.
+ * @param id - ID of the player just started.
+ */
+void watch_player_exits(Game *game, int id) {
+    game->pidFds[id] = pidfd_open(game->pidChildren[id], 0);
+    if (game->pidFds[id] >= 0) {
+        // every table shares one epoll, so each event names its table
+        struct epoll_event event = {.events = EPOLLIN,
+                .data.u64 = (uint64_t) game->tableId << 32 | id};
+        epoll_ctl(game->exitFd, EPOLL_CTL_ADD, game->pidFds[id], &event);
+    }
+}
+
+/**
+ * Function to ask the players to exit by closing their pipes, and release
+ * their shared memory. They have until END_GRACE_MS from the first call to
+ * exit. Calling it again does nothing more.
+ * @param game struct representing hub's tracking of game.
+ */
+void release_players(Game *game) {
+    for (int i = 0; i < game->started; i++) {
+        Player *player = &game->players[i];
+        if (player->pipeIn[1] < 0) {
+            continue;
+        }
+        close(player->pipeIn[1]);
+        close(player->pipeOut[0]);
+        player->pipeIn[1] = -1;
+        player->pipeOut[0] = -1;
+        shm_release(player->link);
+        player->link = NULL;
+        if (!game->endDeadline) {
+            game->endDeadline = timing_now() + END_GRACE_MS * 1000000ULL;
+        }
     }
+}
 
-    // kill children processes
-    end_process(game->pidChildren, game->players, game->playerCount);
+/**
+ * Function to reap the players which have exited, or every player once they
+ * are killed.
+ * @param game struct representing hub's tracking of game.
+ * @param force - 1 to kill any still running and wait for them.
+ * @return number of players still running.
+ */
+int reap_players(Game *game, int force) {
+    int running = 0;
+    for (int i = 0; i < game->started; i++) {
+        pid_t pid = game->pidChildren[i];
+        int pidFd = game->pidFds[i];
+        if (pid < 0) {
+            continue;
+        }
+        // a player which has exited is not running, so cannot be killed
+        if (force && pidFd < 0) {
+            kill(pid, SIGKILL);
+        } else if (force) {
+            pidfd_send_signal(pidFd, SIGKILL, NULL, 0);
+        }
+        if (waitpid(pid, NULL, force ? 0 : WNOHANG) == 0) {
+            running++;
+            continue;
+        }
+        game->pidChildren[i] = -1;
+        if (pidFd >= 0) {
+            epoll_ctl(game->exitFd, EPOLL_CTL_DEL, pidFd, NULL);
+            close(pidFd);
+            game->pidFds[i] = -1;
+        }
+    }
+    return running;
 }
 
 /**
- * Function to end the children processes.
+ * Function to end the players. They are asked to exit, then all waited for
+ * at once until their grace period is over. Any still running are then
+ * killed, and each is reaped by its pid.
  * @param game struct representing hub's tracking of game.
  */
-void end_process(pid_t *children, Player *players, int childrenCount) {
-    // kill children processes
-    for (int i = 0; i < childrenCount; i++) {
-        fclose(players[i].fileOut);
-        fclose(players[i].fileIn);
-        close(players[i].pipeIn[1]);
-        close(players[i].pipeOut[0]);
-        kill(children[i], SIGKILL); //kill children
-        wait(NULL); //reap zombies
+void end_process(Game *game) {
+    release_players(game);
+    struct pollfd fds[game->playerCount];
+    int running = 0;
+    for (int i = 0; i < game->started; i++) {
+        // a negative descriptor is skipped by poll
+        fds[i].fd = game->pidChildren[i] < 0 ? -1 : game->pidFds[i];
+        fds[i].events = POLLIN;
+        running += fds[i].fd >= 0;
     }
+    while (running > 0) {
+        int ready = poll(fds, game->started,
+                deadline_left(game->endDeadline));
+        if (ready == 0 || (ready < 0 && errno != EINTR)) {
+            break;
+        }
+        for (int i = 0; i < game->started; i++) {
+            if (fds[i].fd >= 0 && fds[i].revents) {
+                fds[i].fd = -1;
+                running--;
+            }
+        }
+    }
+    // those which exited are reaped before the rest are killed
+    reap_players(game, 0);
+    reap_players(game, 1);
+    game->endDeadline = 0;
 }
 
 /**
- * Function to handle the overarching game loop.
+ * Function to handle the overarching game loop. The loop never sleeps, it only
+ * blocks in poll while waiting for the player to move (or SIGHUP).
  * @param game struct representing hub's tracking of game.
  * @return 0 - normal exit
+ *         6 - EOF from player
  *         7 - invalid message
  *         8 - invalid card choice.
  *         9 - received SIGHUP
+ *         10 - a player ran out of time
+ *         -2 - the table must wait for a player
  */
 int game_loop(Game *game) {
-    // continue until we get sighup or we return.
-    while (!sighupStruct.sighup) {
-        struct timespec nap;
-        nap.tv_sec = 0;
-        nap.tv_nsec = 5000000000;
-        nanosleep(&nap, 0); // avoid busy waiting.
-
-        if (get_state(game) == START) {
-            // first state, deal cards
-            for (int i = 0; i < game->playerCount; i++) {
-                deal_card_to_player(game, i);
-            }
-            next_state(game);
-            next_state(game);
-            continue;
-        } else if (get_state(game) == NEWROUND) {
-            newround_msg(game);
-        } else if (get_state(game) == PLAYING) {
-            // get played, send play etc.
-            int response = send_and_receive(game);
-            if (response != 0) {
-                return response;
+    // continue until the game ends, or an error (including SIGHUP) occurs.
+    while (true) {
+        uint64_t phaseStart = game->timing ? timing_now() : 0;
+        switch (get_state(game)) {
+            case START:
+                // first state, deal cards
+                for (int i = 0; i < game->playerCount; i++) {
+                    deal_card_to_player(game, i);
+                }
+                next_state(game);
+                next_state(game);
+                if (game->timing) {
+                    histogram_record(&game->phaseTimes[PHASE_DEAL],
+                            timing_now() - phaseStart);
+                }
+                break;
+            case NEWROUND:
+                newround_msg(game);
+                if (game->timing) {
+                    histogram_record(&game->phaseTimes[PHASE_NEWROUND],
+                            timing_now() - phaseStart);
+                }
+                break;
+            case PLAYING: {
+                // get played, send play etc.
+                int response = send_and_receive(game);
+                if (response != 0) {
+                    return response;
+                }
+                next_state(game);
+                break;
             }
-            next_state(game);
-            continue;
-        } else if (get_state(game) == ENDROUND) {
-            // deal with end round
-            end_round_output(game);
-            game->roundNumber++;
-            next_state(game);
-            continue;
-        } else if (get_state(game) == ENDGAME) {
-            // end the game.
-            end_game_output(game);
-            return OK; // exit with normal status.
+            case ENDROUND:
+                // deal with end round
+                end_round_output(game);
+                next_state(game);
+                if (game->timing) {
+                    histogram_record(&game->phaseTimes[PHASE_ENDROUND],
+                            timing_now() - phaseStart);
+                }
+                break;
+            case ENDGAME:
+                // end the game.
+                end_game_output(game);
+                return OK; // exit with normal status.
+            default:
+                break;
         }
     }
-    // kill the children processes.
-    end_process(game->pidChildren, game->players, game->playerCount);
-    return show_message(GOTSIGHUP);
 }
 
 /**
@@ -599,7 +1977,7 @@ int parse(int argc, char **argv, Game *game) {
     //   0      1       2       3        4
     //2310hub deck threshold player0 {player1}
 
-    char *thresholdArg = malloc(sizeof(char) * strlen(argv[2]));
+    char *thresholdArg = calloc(strlen(argv[2]) + 1, sizeof(char));
     for (int s = 0; s < strlen(argv[2]); s++) {
         //check if floating point
         if (argv[2][s] == '.') {
@@ -642,6 +2020,44 @@ int parse(int argc, char **argv, Game *game) {
  *         4 - less than P cards in deck.
  */
 int handler_deck(char *deckName, Game *game) {
+    game->gameNumber = 0;
+    if (game->seeded) {
+        // deckName is the deck spec, nothing is read from the filesystem
+        if (!dealgen_spec(deckName, &game->deal)) {
+            return show_message(BADDECKFILE);
+        }
+        game->source.contents = malloc(sizeof(Card)
+                * dealgen_shoe_size(&game->deal));
+        int status = next_deal(game);
+        if (status != OK) {
+            return show_message(status);
+        }
+        if (game->games == 0) {
+            game->games = 1;
+        }
+        return OK;
+    }
+    if (game->packed) {
+        // the first deal decides the hand size players are started with
+        game->source.contents = malloc(sizeof(Card) * DECKPACK_MAX_CARDS);
+        game->pack = malloc(sizeof(DeckPack));
+        if (!deckpack_open(game->pack, deckName)) {
+            return show_message(BADDECKFILE);
+        }
+        int status = next_deal(game);
+        if (status != OK) {
+            return show_message(status < 0 ? BADDECKFILE : status);
+        }
+        // without --games, play every deal in the pack
+        if (game->games == 0) {
+            game->games = game->pack->dealCount > INT_MAX
+                    ? INT_MAX : game->pack->dealCount;
+        }
+        return OK;
+    }
+    if (game->games == 0) {
+        game->games = 1;
+    }
     FILE *deckFile = fopen(deckName, "r");
     // cannot find the file.
     if (!deckFile) {
@@ -649,19 +2065,48 @@ int handler_deck(char *deckName, Game *game) {
     }
 
     // attempt to load the deck
-    int result = load_deck(deckFile, &game->deck);
+    int result = load_deck(deckFile, &game->source);
     if (result != 0) {
         return result;
     }
     fclose(deckFile);
 
     // check deck size is sufficient.
-    if (game->deck.count < game->playerCount) {
+    if (game->source.count < game->playerCount) {
         return show_message(SHORTDECK);
     }
     return result;
 }
 
+/**
+ * Function to load the next deal of the deck pack (or generate the deal for
+ * this game number from the seed) as the deck for a game.
+ * @param game struct representing hub's tracking of game.
+ * @return 0 - deal loaded
+ *         -1 - no deals left
+ *         3 - the deal is invalid
+ *         4 - less than P cards in the deal.
+ */
+int next_deal(Game *game) {
+    int read = 1;
+    if (game->seeded) {
+        dealgen_deal(game->seed, game->gameNumber, &game->deal,
+                &game->source);
+    } else {
+        read = deckpack_next(game->pack, &game->source);
+    }
+    if (read == 0) {
+        return -1;
+    } else if (read < 0) {
+        return BADDECKFILE;
+    }
+    if (game->source.count < game->playerCount) {
+        return SHORTDECK;
+    }
+    game->numCardsToDeal = deal_hand_size(&game->source, game->playerCount);
+    return OK;
+}
+
 /**
  * Function to check format of card read in from deck
  * @param card - string representing card.
@@ -669,44 +2114,18 @@ int handler_deck(char *deckName, Game *game) {
  *         3 - error in card.
  */
 int check_string(char *card) {
-    //if over 2 char
-    if (strlen(card) > 2) {
-        return show_message(BADDECKFILE);
-    }
-    //ensure letter first
-    if (isalpha(card[0]) == 0) {
-        return show_message(BADDECKFILE);
-    } else {
-        //ensure letter is S, C, D, H
-        if (!validate_card(card[0])) {
-            return show_message(BADDECKFILE);
-        }
-    }
-
-    //ensure letter is captial
-    if (islower(card[0])) {
-        return show_message(BADDECKFILE);
-    }
-
-    //ensure digit or hex last & is lowercase
-    if (isdigit(card[1]) == 0) {
-        if (isxdigit(card[1] == 0)) {
-            return show_message(BADDECKFILE);
-        } else if (isalpha(card[1]) && isxdigit(card[1])) {
-            if (isupper(card[1])) {
-                return show_message(BADDECKFILE);
-            } else {
-                return OK;
-            }
-        }
+    Card parsed;
+    // a capital suit then the rank in lowercase hex, with nothing after it
+    if (text_to_card(card, &parsed) != strlen(card)) {
         return show_message(BADDECKFILE);
     }
-
     return OK;
 }
 
 /**
- * Function to handle running of deck loading.
+ * Function to handle running of deck loading. The deck grows as cards are
+ * read, so its size is not limited, and a shoe may hold several copies of a
+ * card.
  * @param input - deck file to read from.
  * @param deck - deck to read in to.
  * @return 0 - no errors
@@ -714,10 +2133,13 @@ int check_string(char *card) {
  */
 int load_deck(FILE *input, Deck *deck) {
     int position = 0;
+    unsigned int capacity = 0;
+    deck->count = 0;
+    deck->contents = NULL;
+    char card[DECK_WORD_SIZE];
     while (1) {
-        char *card = malloc(sizeof(char) * 4);
-        // read each line of the deck file
-        if (fscanf(input, "%s", card) != 1) {
+        // read each word of the deck file, longer words fail the checks
+        if (fscanf(input, "%15s", card) != 1) {
             break;
         }
         if (position == 0) {
@@ -726,13 +2148,12 @@ int load_deck(FILE *input, Deck *deck) {
                 if (isdigit(card[i]) == 0) {
                     return show_message(BADDECKFILE);
                 }
-                // if we are over 60 (max card number - no duplicates)
-                if (atoi(card) > 60) {
-                    return show_message(BADDECKFILE);
-                }
-                deck->count = atoi(card);
-                deck->contents = malloc(deck->count * sizeof(card));
             }
+            // only checked against the cards read, never allocated up front
+            if (strlen(card) > 9) {
+                return show_message(BADDECKFILE);
+            }
+            deck->count = atoi(card);
         }
         // check if card format is ok
         if (position >= 1) {
@@ -740,11 +2161,12 @@ int load_deck(FILE *input, Deck *deck) {
             if (check != 0) {
                 return check;
             }
-            // create card
-            Card newCard;
-            newCard.suit = card[0];
-            newCard.rank = card[1];
-            deck->contents[position - 1] = newCard;
+            if (position > capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                deck->contents = realloc(deck->contents,
+                        capacity * sizeof(Card));
+            }
+            text_to_card(card, &deck->contents[position - 1]);
         }
         position++;
     }
@@ -760,44 +2182,18 @@ int load_deck(FILE *input, Deck *deck) {
 }
 
 /**
- * Function to set up all malloc'd variables and state of the game.
+ * Function to set up the state of the game, the engine holds the rest.
  * @param game struct representing player's tracking of game.
  */
 void init_state(Game *game) {
-    // initialise all variables needed for storage & state checking.
-    game->state = "start";
-    game->cardsByRound = (Card **) malloc(sizeof(Card *)
-            * game->numCardsToDeal);
-    game->cardsOrderPlayed = (Card **) malloc(sizeof(Card *)
-            * game->numCardsToDeal);
-    game->playerHands = (Card **) malloc(sizeof(Card *)
-            * game->playerCount);
-    game->playerHandSizes = (int *) malloc(sizeof(Card *)
-            * game->playerCount);
-    for (int i = 0; i < game->numCardsToDeal; i++) {
-        game->cardsOrderPlayed[i] = (Card *) malloc(sizeof(Card)
-                * game->playerCount);
-        game->cardsByRound[i] = (Card *) malloc(sizeof(Card)
-                * game->playerCount);
-    }
-
-    game->nScore = (int *) malloc(sizeof(int) * game->playerCount);
-    game->dScore = (int *) malloc(sizeof(int) * game->playerCount);
-    game->finalScores = (int *) malloc(sizeof(int) * game->playerCount);
-    for (int i = 0; i < game->playerCount; i++) {
-        game->nScore[i] = 0;
-        game->dScore[i] = 0;
-        game->finalScores[i] = 0;
-        game->playerHands[i] = (Card *) malloc(sizeof(Card)
-                * game->numCardsToDeal);
-    }
+    game->state = START;
+    game->firstRound = 1;
 }
 
 /**
  * Function to handle the retrival of the current game state.
  * @param game struct representing player's tracking of game.
- * @return -1 if no state
- *         0 if start of game
+ * @return 0 if start of game
  *         1 if hand to be delivered
  *         2 if newround
  *         3 if currently playing the game
@@ -805,20 +2201,7 @@ void init_state(Game *game) {
  *         5 if end of game.
  */
 int get_state(Game *game) {
-    if (strcmp(game->state, "start") == 0) {
-        return START;
-    } else if (strcmp(game->state, "HAND") == 0) {
-        return HAND;
-    } else if (strcmp(game->state, "NEWROUND") == 0) {
-        return NEWROUND;
-    } else if (strcmp(game->state, "PLAYING") == 0) {
-        return PLAYING;
-    } else if (strcmp(game->state, "ENDROUND") == 0) {
-        return ENDROUND;
-    } else if (strcmp(game->state, "ENDGAME") == 0) {
-        return ENDGAME;
-    }
-    return -1;
+    return game->state;
 }
 
 /**
@@ -832,61 +2215,157 @@ int get_state(Game *game) {
  *         5 if end of game.
  */
 int next_state(Game *game) {
-    if (strcmp(game->state, "start") == 0) {
-        // start of game
-        game->state = "HAND";
-        return HAND;
-    } else if (strcmp(game->state, "HAND") == 0) {
-        // given out hands
-        game->state = "NEWROUND";
-        return NEWROUND;
-    } else if (strcmp(game->state, "NEWROUND") == 0) {
-        // send & receive state
-        game->state = "PLAYING";
-        return PLAYING;
-    } else if (strcmp(game->state, "PLAYING") == 0) {
-        // end round stuff
-        game->state = "ENDROUND";
-        return ENDROUND;
-    } else if (strcmp(game->state, "ENDROUND") == 0) {
-        // decide if we should move to endgame or keep playing
-        if (game->roundNumber == game->numCardsToDeal) {
-            game->state = "ENDGAME";
-            return ENDGAME;
-        } else {
-            game->state = "NEWROUND";
-            return NEWROUND;
-        }
+    // state following each state, the end of a round is decided below
+    static const State transitions[HUB_STATES] = {
+            [START] = HAND,
+            [HAND] = NEWROUND,
+            [NEWROUND] = PLAYING,
+            [PLAYING] = ENDROUND,
+            [ENDROUND] = NEWROUND,
+            [ENDGAME] = ENDGAME};
+    State next = transitions[game->state];
+    // decide if we should move to endgame or keep playing
+    if (game->state == ENDROUND
+            && game->engine.roundNumber == game->engine.handSize) {
+        next = ENDGAME;
     }
-    return DONE;
+    game->state = next;
+    return next;
 }
 
 /**
- * Function to handle removal of card from the deck
- * @param game struct representing player's tracking of game.
- * @param card struct representing the card to remove.
- */
-void remove_deck_card(Game *game, Card *card) {
-    int pos = 0;
-    // loop through the deck until we find card required.
-    for (int i = 0; i < game->deck.count; i++) {
-        if (game->deck.contents[i].suit == card->suit) {
-            if (game->deck.contents[i].rank == card->rank) {
-                pos = i;
-                break;
+ * Function to parse the options which may come before the deck argument.
+ *   --games N         play N games in a row with the same player processes.
+ *   --binary          offer players the binary wire protocol.
+ *   --deck-pack FILE  deal each game from a deck pack ("-" for stdin), which
+ *                     replaces the deck argument.
+ *   --seed S          generate each game's deal from seed S, which replaces
+ *                     the deck argument.
+ *   --deck-spec SPEC  cards in generated deals: "standard", a number, or
+ *                     "shoe:D[:R]" for D decks of ranks 1 to R.
+ *   --timing          print response and phase times to stderr.
+ *   --move-timeout MS give up if a player takes more than MS milliseconds to
+ *                     move.
+ *   --game-timeout MS give up if a game takes more than MS milliseconds.
+ *   --start-timeout MS
+ *                     give up if the players take more than MS milliseconds
+ *                     to start.
+ *   --tables T        play T games at once, each with its own players.
+ *   --mux             have one process for each seat serve every table.
+ *   --log FILE        append each finished game to a game log.
+ *   --transport T     "pipe" (the default) or "shm" to offer players shared
+ *                     memory rings instead of pipes.
+ *   --spin N          check a ring N times before sleeping on it.
+ * @param argc - number of arguments supplied
+ * @param argv - arguments supplied at command line.
+ * @param options - struct to fill with the options found.
+ * @return index of the deck argument in argv
+ *         -1 if an option was invalid.
+ */
+int parse_options(int argc, char **argv, HubOptions *options) {
+    static struct option longOptions[] = {
+            {"games", required_argument, 0, 'g'},
+            {"binary", no_argument, 0, 'b'},
+            {"deck-pack", required_argument, 0, 'p'},
+            {"seed", required_argument, 0, 's'},
+            {"deck-spec", required_argument, 0, 'd'},
+            {"timing", no_argument, 0, 't'},
+            {"move-timeout", required_argument, 0, 'm'},
+            {"game-timeout", required_argument, 0, 'G'},
+            {"start-timeout", required_argument, 0, 'u'},
+            {"tables", required_argument, 0, 'T'},
+            {"mux", no_argument, 0, 'x'},
+            {"log", required_argument, 0, 'l'},
+            {"transport", required_argument, 0, 'r'},
+            {"spin", required_argument, 0, 'S'},
+            {0, 0, 0, 0}};
+    options->games = 0;
+    options->binary = 0;
+    options->deckPack = NULL;
+    options->deckSpec = NULL;
+    options->seed = 0;
+    options->timing = 0;
+    options->moveTimeout = 0;
+    options->gameTimeout = 0;
+    options->startTimeout = 0;
+    options->tables = 1;
+    options->mux = 0;
+    options->log = NULL;
+    options->shm = 0;
+    options->spin = 0;
+    opterr = 0; // we show our own usage message.
+    int opt;
+    // '+' stops at the deck argument so players are never treated as options
+    while ((opt = getopt_long(argc, argv, "+", longOptions, 0)) != -1) {
+        if (opt == 'g') {
+            char *end;
+            long games = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || games < 1
+                    || games > INT_MAX) {
+                return -1;
+            }
+            options->games = games;
+        } else if (opt == 'b') {
+            options->binary = 1;
+        } else if (opt == 'p') {
+            options->deckPack = optarg;
+        } else if (opt == 's') {
+            char *end;
+            errno = 0;
+            options->seed = strtoull(optarg, &end, 10);
+            if (!isdigit(*optarg) || *end != '\0' || errno == ERANGE) {
+                return -1;
+            }
+            if (!options->deckSpec) {
+                options->deckSpec = DEALGEN_DEFAULT_SPEC;
+            }
+        } else if (opt == 'd') {
+            options->deckSpec = optarg;
+        } else if (opt == 't') {
+            options->timing = 1;
+        } else if (opt == 'x') {
+            options->mux = 1;
+        } else if (opt == 'l') {
+            options->log = optarg;
+        } else if (opt == 'r' && (strcmp(optarg, "pipe") == 0
+                || strcmp(optarg, "shm") == 0)) {
+            options->shm = strcmp(optarg, "shm") == 0;
+        } else if (opt == 'm' || opt == 'G' || opt == 'u' || opt == 'T'
+                || opt == 'S') {
+            char *end;
+            long number = strtol(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0' || number < 1
+                    || number > INT_MAX) {
+                return -1;
             }
+            if (opt == 'm') {
+                options->moveTimeout = number;
+            } else if (opt == 'G') {
+                options->gameTimeout = number;
+            } else if (opt == 'u') {
+                options->startTimeout = number;
+            } else if (opt == 'S') {
+                options->spin = number;
+            } else {
+                options->tables = number;
+            }
+        } else {
+            return -1;
         }
     }
-    for (int q = pos; q < game->deck.count - 1; q++) {
-        // shift all cards to compensate for removal.
-        game->deck.contents[q] = game->deck.contents[q + 1];
+    // deals come from one place only, tagged lines are text only and rings
+    // are only read by the single table loop
+    if ((options->deckPack && options->deckSpec)
+            || (options->mux && options->binary)
+            || (options->shm && (options->tables > 1 || options->mux))) {
+        return -1;
     }
-    game->deck.count -= 1;
-    game->deck.used += 1;
+    return optind;
 }
 
 /**
- * Function acting as entry point for the program.
+ * Function acting as entry point for the program. Run as 2310alice or
+ * 2310bob it plays that player instead, with the player's exit statuses.
  * @param argc - number of arguments received at command line
  * @param argv - array of strings representing arguments received.
  * @return 0 - normal exit
@@ -899,16 +2378,34 @@ void remove_deck_card(Game *game, Card *card) {
  *         7 - invalid message from a player
  *         8 - player chooses a card they do not have.
  *         9 - received SIGHUP
+ *         10 - a player took longer than --move-timeout, --game-timeout or
+ *              --start-timeout
+ *         11 - the --log file could not be opened.
  */
 int main(int argc, char **argv) {
+    const StrategyPlugin *builtin = builtin_player(argv[0]);
+    if (builtin) {
+        return run_player(argc, argv, builtin);
+    }
+    HubOptions options;
+    int deckArg = parse_options(argc, argv, &options);
+    if (deckArg < 0) {
+        return show_message(LESS4ARGS);
+    }
+    // drop the options so the deck is argv[1] again, a deck pack or deck
+    // spec takes the place of the deck argument.
+    char *deck = options.deckPack ? options.deckPack : options.deckSpec;
+    int dropped = deck ? deckArg - 2 : deckArg - 1;
+    argv[dropped] = argv[0];
+    if (deck) {
+        argv[dropped + 1] = deck;
+    }
+    argv += dropped;
+    argc -= dropped;
+
     // start the game if we have correct number of args.
     if (argc >= 5) {
-        // setup SIGHUP detection
-        struct sigaction saSighup;
-        saSighup.sa_handler = handle_sighup;
-        saSighup.sa_flags = SA_RESTART;
-        sigaction(SIGHUP, &saSighup, 0);
-        return new_game(argc, argv);
+        return new_game(argc, argv, &options);
     } else {
         return show_message(LESS4ARGS);
     }
@@ -1,48 +1,120 @@
 #include "shared.h"
+#include "engine.h"
+#include "deckpack.h"
+#include "dealgen.h"
+#include "timing.h"
+#include "gamelog.h"
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <poll.h>
 
 #ifndef HUB_H
 #define HUB_H
 
+/* enum for the phases of a game timed by --timing */
+typedef enum {
+    PHASE_DEAL = 0, // building every HAND message
+    PHASE_NEWROUND = 1, // newround_msg
+    PHASE_ENDROUND = 2, // end_round_output
+} Phase;
+
+// number of timed phases
+#define HUB_PHASES 3
+
+// room for one word of a deck file, read with "%15s" by load_deck
+#define DECK_WORD_SIZE 16
+
+// games between timing reports in long runs
+#define TIMING_REPORT_GAMES 1000
+
+// milliseconds players are given to exit once their pipes are closed
+#define END_GRACE_MS 100
+
+// pidFd events taken from the epoll in one check for exited players
+#define HUB_EXIT_EVENTS 16
+
 // struct for the game
 typedef struct {
-    Deck deck;
     Play *board;
     Player *players;
     char *types;
     unsigned int current; // will be 0 - playerNumber
     int threshold;
     int playerCount;
-    int leadPlayer;
-    char leadSuit;
     int numCardsToDeal;
     pid_t *pidChildren;
+    int *pidFds; // pidfd of each player's process, -1 if it has none.
+    int started; // players create_players has started, pidChildren -1 once
+                 // reaped.
+    uint64_t endDeadline; // when players asked to exit are killed, 0 if none
+                          // have been.
 
-    char *state;
-    int roundNumber; // 1 based.
+    int state; // a State, see below.
     int firstRound; //0 if not, 1 if so.
-    Card **cardsByRound;
-    Card **cardsOrderPlayed;
-    int *nScore;
-    int *dScore;
-    int *finalScores;
     int lastPlayer;
+    EngineGame engine; // hands, tricks and scores of the current game.
+
+    Deck source; // pristine copy of the deck, dealt from once per game.
+    DeckPack *pack; // deals for each game when packed, shared by tables.
+    int packed; // 1 if the deck argument is a deck pack.
+    int seeded; // 1 if deals are generated from seed.
+    uint64_t seed;
+    DealSpec deal; // what each generated deal holds.
+    int games; // number of games to play with the same players.
+    int gameNumber; // 0 based.
+
+    int signalFd; // becomes readable when SIGHUP arrives.
+    int exitFd; // epoll of the pidFds, readable once a player has exited.
+    int binary; // 1 if players are offered the binary protocol.
 
-    Card **playerHands;
-    int *playerHandSizes;
+    int timing; // 1 if response and phase times are recorded.
+    Histogram *moveTimes; // per player, from their turn to their PLAY.
+    Histogram phaseTimes[HUB_PHASES];
+
+    int moveTimeout; // milliseconds each move may take, 0 for no limit.
+    int gameTimeout; // milliseconds each game may take, 0 for no limit.
+    int startTimeout; // milliseconds to wait for handshakes, 0 for no limit.
+    uint64_t moveDeadline; // monotonic time the current move must arrive by.
+    uint64_t gameDeadline; // monotonic time the current game must end by.
+
+    FILE *results; // where round and game results are printed.
+    char *resultsText; // results of the current game, for tables.
+    size_t resultsLength;
+    int multiplexed; // 1 if the hub's event loop reads the players' input.
+    int awaiting; // 1 once the current mover has been sent its messages.
+    uint64_t turnStart; // when the current mover was sent its messages.
+    int tableGames; // games this table has started.
+    int closed; // 1 once a table has no games left.
+    int tableId; // position among the hub's tables, tags its pidFd events.
+    int mux; // 1 if one process for each seat serves every table.
+    FILE *log; // where finished games are appended, NULL if not logged.
+    int shm; // 1 if players are offered shared memory rings, see shmring.h.
+    int spin; // times a ring is checked before sleeping on it.
+    uint64_t lastWatch; // when players and SIGHUP were last checked for.
 } Game;
 
-// global struct for SIGHUP signal.
+// bytes in a cache line, no two tables share one
+#define HUB_CACHE_LINE 64
+
+/* struct for one table of a multi-table hub */
 typedef struct {
-    bool sighup;
-    pid_t *pidChildren;
-    Player *players;
-    int playerCount;
-} SighupVars;
+    Game game;
+} __attribute__((aligned(HUB_CACHE_LINE))) Table;
+
+/* struct for every table of a multi-table hub, which share game numbers */
+typedef struct {
+    Table *tables;
+    int count; // tables opened.
+    int open; // tables with games left.
+    int nextGame; // game number the next table to need a deal gets.
+    int played; // games finished on every table.
+    struct pollfd *fds; // every player of every table, then the signalfd.
+    int mux; // 1 if the first table's processes serve every table.
+    Player *seats; // each seat's process when multiplexed, lines untagged.
+} Tables;
 
 /* enum for hub exit status */
 typedef enum {
@@ -55,7 +127,10 @@ typedef enum {
     PLAYEREOF = 6,
     PLAYERMSG = 7,
     PLAYERCHOICE = 8,
-    GOTSIGHUP = 9
+    GOTSIGHUP = 9,
+    PLAYERTIMEOUT = 10,
+    LOGERROR = 11,
+    WAITING = -2 // not an exit status, a table is waiting for input.
 } Status;
 
 /* enum for state machine */
@@ -68,16 +143,137 @@ typedef enum {
     ENDGAME = 5,
 } State;
 
-void end_process(pid_t *children, Player *players, int childrenCount);
+// number of states in the hub's state machine
+#define HUB_STATES 6
+
+/* command line options given before the deck argument */
+typedef struct {
+    int games; // 0 if not given.
+    int binary;
+    char *deckPack; // NULL if not given.
+    char *deckSpec; // NULL unless --seed or --deck-spec was given.
+    uint64_t seed;
+    int timing;
+    int moveTimeout; // milliseconds, 0 if not given.
+    int gameTimeout; // milliseconds, 0 if not given.
+    int startTimeout; // milliseconds, 0 if not given.
+    int tables; // games played at once, each with its own players.
+    int mux; // 1 if each seat's player process serves every table.
+    char *log; // NULL if not given.
+    int shm; // 1 if --transport shm was given.
+    int spin; // 0 if not given.
+} HubOptions;
+
+// struct for a player built into the hub, which 2310alice and 2310bob link to
+typedef struct {
+    const char *name; // program name the player is run as.
+    const StrategyPlugin *plugin;
+} BuiltinPlayer;
+
+const StrategyPlugin *builtin_player(const char *name);
+
+const StrategyPlugin *builtin_path(const char *path);
+
+void release_players(Game *game);
+
+int reap_players(Game *game, int force);
+
+void end_process(Game *game);
+
+void watch_player_exits(Game *game, int id);
+
+void watch_hub_events(Game *game, struct pollfd *fds);
+
+int input_ready(struct pollfd *fds, int count);
 
 int handler_deck(char *deckName, Game *game);
 
 int load_deck(FILE *input, Deck *deck);
 
-void handle_sighup(int s);
+int deal_hand_size(const Deck *deck, int playerCount);
+
+int next_deal(Game *game);
+
+int setup_sighup(void);
+
+int fill_player_input(Game *game, int id);
+
+int read_player_input(Player *player);
+
+int fill_ring_input(Game *game, int id);
+
+int watch_players(Game *game);
+
+int player_hung_up(Player *player);
+
+int time_left(Game *game);
+
+int deadline_left(uint64_t deadline);
+
+int take_player_line(Player *player, char *line, int size);
+
+void reserve_output(Player *player, int extra);
+
+void queue_message(Player *player, const char *format, ...);
+
+int flush_player(Player *player);
+
+int flush_ring(Player *player);
+
+int flush_players(Game *game);
+
+void queue_record(Player *player, int type, int number);
+
+void queue_played(Player *player, int id, Card card);
+
+int receive_play(Game *game, int player, Card *card);
+
+int validate_play(Game *game, char *message, int player, Card *newCard);
+
+int check_card_in_hand(Game *game, Card *card, int player);
+
+int deal_card_to_player(Game *game, int id);
 
 int game_loop(Game *game);
 
+void print_timing(Game *game, int played);
+
+int open_log(Game *game, const char *name);
+
+void log_game(Game *game);
+
+int parse_options(int argc, char **argv, HubOptions *options);
+
+int play_games(Game *game);
+
+void queue_newgame(Game *game);
+
+int play_tables(Game *first, int tableCount, char **argv);
+
+int open_table(Tables *all, Game *first, Game *table, char **argv);
+
+int next_table_game(Tables *all, Game *table);
+
+int step_table(Tables *all, Game *table);
+
+int poll_tables(Tables *all);
+
+void share_players(Game *table, Game *owner, int tag);
+
+int poll_mux(Tables *all);
+
+int route_mux_input(Tables *all, int seat);
+
+void print_table_timing(Tables *all);
+
+void reap_tables(Tables *all);
+
+int table_player_exited(Tables *all);
+
+void end_tables(Tables *all);
+
+void start_next_game(Game *game);
+
 Status show_message(Status s);
 
 int parse(int argc, char **argv, Game *game);
@@ -88,6 +284,4 @@ int get_state(Game *game);
 
 int next_state(Game *game);
 
-void remove_deck_card(Game *game, Card *card);
-
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "deckpack.h"
+
+/**
+ * Function to read a deck file in the hub's text format.
+ * @param name - file name of the deck.
+ * @param deck - deck to fill, its cards are allocated to fit.
+ * @return 1 if the deck was read, 0 if it is missing or invalid.
+ */
+int read_text_deck(const char *name, Deck *deck) {
+    FILE *input = fopen(name, "r");
+    deck->count = 0;
+    deck->contents = NULL;
+    if (!input) {
+        return 0;
+    }
+    char word[16];
+    int count;
+    int valid = fscanf(input, "%d", &count) == 1 && count > 0
+            && count <= DECKPACK_MAX_CARDS;
+    if (valid) {
+        deck->contents = malloc(sizeof(Card) * count);
+    }
+    while (valid && fscanf(input, "%15s", word) == 1) {
+        // same rules as the hub: suit, then the rank in lowercase hex
+        valid = deck->count < count && text_to_card(word,
+                &deck->contents[deck->count]) == strlen(word);
+        deck->count++;
+    }
+    valid = valid && feof(input) && deck->count == count;
+    fclose(input);
+    return valid;
+}
+
+/**
+ * Function acting as entry point for the program, converting the text decks
+ * named on the command line into one deck pack written to stdout, one deal
+ * per deck in the order given.
+ * @param argc - number of arguments supplied at command line.
+ * @param argv - array of strings supplied at startup.
+ * @return 0 - pack written
+ *         1 - no decks given
+ *         3 - a deck could not be read.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: 2310pack deck {deck} > pack\n");
+        return 1;
+    }
+    int count = argc - 1;
+    Deck *decks = malloc(sizeof(Deck) * count);
+    for (int i = 0; i < count; i++) {
+        if (!read_text_deck(argv[i + 1], &decks[i])) {
+            fprintf(stderr, "Error reading deck %s\n", argv[i + 1]);
+            return 3;
+        }
+    }
+    deckpack_write_header(stdout, count);
+    deckpack_write_index(stdout, decks, count);
+    for (int i = 0; i < count; i++) {
+        deckpack_write_deal(stdout, &decks[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        free(decks[i].contents);
+    }
+    free(decks);
+    return fflush(stdout) == 0 ? 0 : 3;
+}
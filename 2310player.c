@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "shared.h"
+#include "plugin.h"
+
+/**
+ * Function acting as entry point for the program when first loaded. Plays
+ * like alice and bob, with the strategy loaded from a plug-in.
+ * @param argc - number of arguments supplied at command line.
+ * @param argv - plug-in, then the arguments alice and bob take.
+ * @return 0 - normal exit
+ *         1 - incorrect number of arguments
+ *         2 - number of players < 2 or not a number
+ *         3 - invalid position for number of players
+ *         4 - threshold < 2 or not a number
+ *         6 - invalid message from hub.
+ *         7 - unexpected EOF from hub
+ *         8 - the plug-in could not be loaded or did not pick a card.
+ */
+int main(int argc, char **argv) {
+    if (argc != 6) {
+        // incorrect arg count.
+        return show_player_message(ARGERR);
+    }
+    const StrategyPlugin *plugin = plugin_load(argv[1]);
+    if (!plugin) {
+        return show_player_message(STRATEGYERR);
+    }
+    // the plug-in takes the place of the program name
+    return run_player(argc - 1, argv + 1, plugin);
+}
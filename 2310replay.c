@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include "2310replay.h"
+
+/**
+ * Function to handle printing error messages to stderr.
+ * @param s - which status to show
+ * @return the error status.
+ */
+ReplayStatus show_replay_message(ReplayStatus s) {
+    const char *messages[] = {"",
+            "Usage: 2310replay [--threads T] log\n",
+            "Invalid game log\n",
+            "Recorded results do not match\n"};
+    fputs(messages[s], stderr);
+    return s;
+}
+
+/**
+ * Function to handle the parsing of command line arguments.
+ * @param argc - number of arguments supplied
+ * @param argv - arguments supplied at command line.
+ * @param replay - settings to fill in.
+ * @param name - where to store the file name of the log.
+ * @return 0 - all ok
+ *         1 - usage error.
+ */
+int parse_replay(int argc, char **argv, Replay *replay, char **name) {
+    static struct option longOptions[] = {
+            {"threads", required_argument, 0, 't'},
+            {0, 0, 0, 0}};
+    memset(replay, 0, sizeof(Replay));
+    replay->threads = sysconf(_SC_NPROCESSORS_ONLN);
+    opterr = 0; // we show our own usage message.
+    int opt;
+    while ((opt = getopt_long(argc, argv, "+", longOptions, 0)) != -1) {
+        char *end;
+        errno = 0;
+        long value = opt == 't' ? strtol(optarg, &end, 10) : 0;
+        if (opt != 't' || !isdigit(*optarg) || *end != '\0' || errno != 0
+                || value < 1 || value > INT_MAX) {
+            return show_replay_message(REPLAY_USAGE);
+        }
+        replay->threads = value;
+    }
+    if (replay->threads < 1) {
+        replay->threads = 1;
+    }
+    if (argc - optind != 1) {
+        return show_replay_message(REPLAY_USAGE);
+    }
+    *name = argv[optind];
+    return REPLAY_OK;
+}
+
+/**
+ * Function to find every game of a log, so workers can take them in any
+ * order. Records point into the log's mapping, nothing is copied.
+ * @param log - opened log.
+ * @param replay - where to store the games found.
+ * @return 0 - every game found
+ *         2 - the log is cut short or a game's header is invalid.
+ */
+ReplayStatus load_records(GameLog *log, Replay *replay) {
+    long capacity = 1024;
+    replay->records = malloc(sizeof(GameRecord) * capacity);
+    int found;
+    while ((found = gamelog_next(log, &replay->records[replay->games])) > 0) {
+        if (++replay->games == capacity) {
+            capacity *= 2;
+            replay->records = realloc(replay->records,
+                    sizeof(GameRecord) * capacity);
+        }
+    }
+    return found == 0 ? REPLAY_OK : REPLAY_BADLOG;
+}
+
+/**
+ * Function to play a recorded game again from its deal, checking every lead
+ * and the final scores against those recorded.
+ * @param record - game to replay.
+ * @param engine - engine for the game's number of players.
+ * @param deal - room for the game's players x hand size cards.
+ * @return 1 if the game plays out as recorded, 0 if not.
+ */
+int replay_game(const GameRecord *record, EngineGame *engine, Card *deal) {
+    int count = record->playerCount;
+    for (int i = 0; i < count * record->handSize; i++) {
+        deal[i] = wire_to_card(record->deal[i]);
+    }
+    engine->threshold = record->threshold;
+    engine_deal(engine, deal, record->handSize);
+    for (int r = 0; r < record->handSize; r++) {
+        int lead = gamelog_lead(record, r);
+        if (lead != engine->leadPlayer) {
+            return 0;
+        }
+        for (int j = 0; j < count; j++) {
+            Card card = wire_to_card(record->order[r * count + j]);
+            if (engine_play(engine, (lead + j) % count, card)
+                    > ENGINE_GAMEOVER) {
+                return 0;
+            }
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (engine->finalScores[i] != gamelog_score(record, i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function run by each worker thread, claiming games in chunks until none
+ * are left. Each worker has its own engine, which is set up again whenever
+ * the number of players changes, and a deal which grows to fit each game.
+ * @param arg - the worker.
+ * @return NULL.
+ */
+void *run_replay_worker(void *arg) {
+    ReplayWorker *worker = arg;
+    Replay *replay = worker->replay;
+    Card *deal = NULL;
+    size_t dealSize = 0;
+    EngineGame engine;
+    engine_init(&engine, 2, 2);
+
+    long start;
+    while ((start = __atomic_fetch_add(&replay->nextGame, REPLAY_CHUNK,
+            __ATOMIC_RELAXED)) < replay->games) {
+        long end = start + REPLAY_CHUNK < replay->games
+                ? start + REPLAY_CHUNK : replay->games;
+        for (long k = start; k < end; k++) {
+            const GameRecord *record = &replay->records[k];
+            size_t cells = (size_t) record->playerCount * record->handSize;
+            if (cells > dealSize) {
+                dealSize = cells;
+                deal = realloc(deal, sizeof(Card) * dealSize);
+            }
+            if (record->playerCount != engine.playerCount) {
+                engine_free(&engine);
+                engine_init(&engine, record->playerCount, record->threshold);
+            }
+            if (replay_game(record, &engine, deal)) {
+                worker->verified++;
+                continue;
+            }
+            worker->mismatched++;
+            if (__atomic_fetch_add(&replay->reported, 1, __ATOMIC_RELAXED)
+                    < REPLAY_REPORTED) {
+                fprintf(stderr, "Mismatch in game %lu (record %ld)\n",
+                        (unsigned long) record->number, k);
+            }
+        }
+    }
+
+    engine_free(&engine);
+    free(deal);
+    return NULL;
+}
+
+/**
+ * Function to replay every game across the worker threads and add up what
+ * each worker found once they are done.
+ * @param replay - games of the log.
+ * @param verified - where to store the number of games matching the log.
+ * @param mismatched - where to store the number of games that did not.
+ */
+void run_replay(Replay *replay, long *verified, long *mismatched) {
+    ReplayWorker *workers = calloc(replay->threads, sizeof(ReplayWorker));
+    for (int i = 0; i < replay->threads; i++) {
+        workers[i].replay = replay;
+        pthread_create(&workers[i].thread, NULL, run_replay_worker,
+                &workers[i]);
+    }
+    *verified = 0;
+    *mismatched = 0;
+    for (int i = 0; i < replay->threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        *verified += workers[i].verified;
+        *mismatched += workers[i].mismatched;
+    }
+    free(workers);
+}
+
+/**
+ * Function acting as entry point for the program.
+ * @param argc - number of arguments received at command line
+ * @param argv - array of strings representing arguments received.
+ * @return 0 - every game matches the log
+ *         1 - usage error
+ *         2 - log missing, cut short or not a game log
+ *         3 - some game does not match the log.
+ */
+int main(int argc, char **argv) {
+    Replay replay;
+    char *name;
+    int parseStatus = parse_replay(argc, argv, &replay, &name);
+    if (parseStatus != REPLAY_OK) {
+        return parseStatus;
+    }
+    GameLog log;
+    if (!gamelog_open(&log, name)) {
+        gamelog_close(&log);
+        return show_replay_message(REPLAY_BADLOG);
+    }
+    ReplayStatus status = load_records(&log, &replay);
+    if (status != REPLAY_OK) {
+        free(replay.records);
+        gamelog_close(&log);
+        return show_replay_message(status);
+    }
+    long verified, mismatched;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_replay(&replay, &verified, &mismatched);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Games=%ld Verified=%ld Mismatched=%ld\n", replay.games, verified,
+            mismatched);
+    // timing goes to stderr so the results are the same on every run
+    double seconds = (end.tv_sec - start.tv_sec)
+            + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Threads=%d Seconds=%.3f Games/sec=%.0f\n",
+            replay.threads, seconds, replay.games / seconds);
+    free(replay.records);
+    gamelog_close(&log);
+    return mismatched ? show_replay_message(REPLAY_MISMATCH) : REPLAY_OK;
+}
@@ -0,0 +1,52 @@
+#include "shared.h"
+#include "engine.h"
+#include "gamelog.h"
+#include <pthread.h>
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// games a worker claims from the shared counter at a time
+#define REPLAY_CHUNK 256
+
+// mismatched games reported on stderr before the rest are only counted
+#define REPLAY_REPORTED 10
+
+/* enum for replay exit status */
+typedef enum {
+    REPLAY_OK = 0,
+    REPLAY_USAGE = 1,
+    REPLAY_BADLOG = 2,
+    REPLAY_MISMATCH = 3
+} ReplayStatus;
+
+// struct for the games of a log shared by every worker
+typedef struct {
+    GameRecord *records;
+    long games;
+    int threads;
+    long nextGame; // next game not yet claimed by a worker.
+    long reported; // mismatches reported so far.
+} Replay;
+
+// struct for a worker thread
+typedef struct {
+    Replay *replay;
+    pthread_t thread;
+    long verified;
+    long mismatched;
+} ReplayWorker;
+
+ReplayStatus show_replay_message(ReplayStatus s);
+
+int parse_replay(int argc, char **argv, Replay *replay, char **name);
+
+ReplayStatus load_records(GameLog *log, Replay *replay);
+
+int replay_game(const GameRecord *record, EngineGame *engine, Card *deal);
+
+void *run_replay_worker(void *arg);
+
+void run_replay(Replay *replay, long *verified, long *mismatched);
+
+#endif
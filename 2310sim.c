@@ -0,0 +1,458 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include "2310sim.h"
+#include "2310alice.h"
+#include "2310bob.h"
+#include "2310carol.h"
+
+/**
+ * Function to handle printing error messages to stderr.
+ * @param s - which status to show
+ * @return the error status.
+ */
+SimStatus show_sim_message(SimStatus s) {
+    const char *messages[] = {"",
+            "Usage: 2310sim [--games N] [--threads T] [--seed S] "
+            "[--deck-spec spec] threshold strategy0 {strategy1}\n",
+            "Invalid threshold\n",
+            "Deck error\n",
+            "Not enough cards\n",
+            "Unknown strategy\n",
+            "Invalid move from strategy\n"};
+    fputs(messages[s], stderr);
+    return s;
+}
+
+/**
+ * Function to parse a positive number given on the command line.
+ * @param arg - string to parse.
+ * @param value - where to store the number.
+ * @return 1 if arg is a number between 1 and INT_MAX, 0 if not.
+ */
+int parse_count(const char *arg, long *value) {
+    char *end;
+    errno = 0;
+    *value = strtol(arg, &end, 10);
+    return isdigit(*arg) && *end == '\0' && errno == 0 && *value >= 1
+            && *value <= INT_MAX;
+}
+
+/**
+ * Function to handle the parsing of command line arguments.
+ * @param argc - number of arguments supplied
+ * @param argv - arguments supplied at command line.
+ * @param sim - settings to fill in.
+ * @return 0 - all ok
+ *         1 - usage error
+ *         2 - error in threshold
+ *         3 - invalid deck spec
+ *         4 - less than P cards in each deal
+ *         5 - unknown strategy name or plug-in that does not load.
+ */
+int parse_sim(int argc, char **argv, Sim *sim) {
+    static struct option longOptions[] = {
+            {"games", required_argument, 0, 'g'},
+            {"threads", required_argument, 0, 't'},
+            {"seed", required_argument, 0, 's'},
+            {"deck-spec", required_argument, 0, 'd'},
+            {0, 0, 0, 0}};
+    const char *spec = DEALGEN_DEFAULT_SPEC;
+    long value;
+    sim->games = 1000;
+    sim->threads = sysconf(_SC_NPROCESSORS_ONLN);
+    sim->seed = 0;
+    opterr = 0; // we show our own usage message.
+    int opt;
+    while ((opt = getopt_long(argc, argv, "+", longOptions, 0)) != -1) {
+        if (opt == 'g' && parse_count(optarg, &value)) {
+            sim->games = value;
+        } else if (opt == 't' && parse_count(optarg, &value)) {
+            sim->threads = value;
+        } else if (opt == 's' && isdigit(*optarg)) {
+            char *end;
+            errno = 0;
+            sim->seed = strtoull(optarg, &end, 10);
+            if (*end != '\0' || errno == ERANGE) {
+                return show_sim_message(SIM_USAGE);
+            }
+        } else if (opt == 'd') {
+            spec = optarg;
+        } else {
+            return show_sim_message(SIM_USAGE);
+        }
+    }
+    if (sim->threads < 1) {
+        sim->threads = 1;
+    }
+    // threshold and at least two strategies must follow the options
+    if (argc - optind < 3) {
+        return show_sim_message(SIM_USAGE);
+    }
+    if (!parse_count(argv[optind], &value) || value < 2) {
+        return show_sim_message(SIM_THRESHOLD);
+    }
+    sim->threshold = value;
+    if (!dealgen_spec(spec, &sim->deal)) {
+        return show_sim_message(SIM_DECKSPEC);
+    }
+    sim->playerCount = argc - optind - 1;
+    sim->handSize = sim->deal.cards / sim->playerCount;
+    if (sim->handSize < 1) {
+        return show_sim_message(SIM_SHORTDECK);
+    }
+
+    // strategies are named the same way as the player programs
+    sim->names = argv + optind + 1;
+    sim->plugins = malloc(sizeof(*sim->plugins) * sim->playerCount);
+    for (int i = 0; i < sim->playerCount; i++) {
+        if (strcmp(sim->names[i], "alice") == 0) {
+            sim->plugins[i] = &alicePlugin;
+        } else if (strcmp(sim->names[i], "bob") == 0) {
+            sim->plugins[i] = &bobPlugin;
+        } else if (strcmp(sim->names[i], "carol") == 0) {
+            sim->plugins[i] = &carolPlugin;
+        } else if (is_plugin(sim->names[i])) {
+            sim->plugins[i] = plugin_load(sim->names[i]);
+        } else {
+            sim->plugins[i] = NULL;
+        }
+        if (!sim->plugins[i]) {
+            return show_sim_message(SIM_STRATEGY);
+        }
+    }
+    sim->nextGame = 0;
+    return SIM_OK;
+}
+
+/**
+ * Function to set up empty stats for a number of seats.
+ * @param stats - stats to set up.
+ * @param playerCount - number of seats.
+ * @param dealCards - cards in each deal.
+ */
+void init_stats(SimStats *stats, int playerCount, int dealCards) {
+    stats->games = 0;
+    stats->scoreOffset = dealCards;
+    stats->scoreRange = 2 * dealCards + 1;
+    stats->wins = calloc(playerCount, sizeof(long));
+    stats->scoreSum = calloc(playerCount, sizeof(long));
+    stats->histogram = calloc(playerCount * stats->scoreRange, sizeof(long));
+}
+
+/**
+ * Function to release the storage of stats.
+ * @param stats - stats to free.
+ */
+void free_stats(SimStats *stats) {
+    free(stats->wins);
+    free(stats->scoreSum);
+    free(stats->histogram);
+}
+
+/**
+ * Function to add the final scores of a finished game to a worker's stats.
+ * @param stats - stats of the worker.
+ * @param engine - engine holding the finished game.
+ */
+void record_game(SimStats *stats, EngineGame *engine) {
+    int best = engine->finalScores[0];
+    for (int i = 1; i < engine->playerCount; i++) {
+        if (engine->finalScores[i] > best) {
+            best = engine->finalScores[i];
+        }
+    }
+    for (int i = 0; i < engine->playerCount; i++) {
+        int score = engine->finalScores[i];
+        stats->wins[i] += score == best;
+        stats->scoreSum[i] += score;
+        stats->histogram[i * stats->scoreRange + score
+                + stats->scoreOffset]++;
+    }
+    stats->games++;
+}
+
+/**
+ * Function to add one worker's stats into the totals.
+ * @param total - stats to add to.
+ * @param part - stats of a worker.
+ * @param playerCount - number of seats.
+ */
+void merge_stats(SimStats *total, SimStats *part, int playerCount) {
+    total->games += part->games;
+    for (int i = 0; i < playerCount; i++) {
+        total->wins[i] += part->wins[i];
+        total->scoreSum[i] += part->scoreSum[i];
+    }
+    for (int i = 0; i < playerCount * total->scoreRange; i++) {
+        total->histogram[i] += part->histogram[i];
+    }
+}
+
+/**
+ * Function to set up a player the way its program would after parsing its
+ * arguments, except that its moves are collected instead of printed.
+ * @param sim - settings of the simulation.
+ * @param player - player to set up.
+ * @param id - seat of the player.
+ * @return 0 - set up
+ *         6 - the player's storage could not be allocated.
+ */
+int init_sim_player(Sim *sim, PlayerGame *player, int id) {
+    memset(player, 0, sizeof(PlayerGame));
+    player->playerCount = sim->playerCount;
+    player->myID = id;
+    player->threshold = sim->threshold;
+    player->handSize = sim->handSize;
+    int status = init_expected(player);
+    if (status != DONE) {
+        return status;
+    }
+    player->simulated = 1;
+    use_plugin(player, sim->plugins[id]);
+    return DONE;
+}
+
+/**
+ * Function to play one round once every player has been told it started.
+ * Each move is passed to the others as PLAYED would be, which is when the
+ * next player makes its own move.
+ * @param players - every player of the game.
+ * @param engine - engine holding the game.
+ * @return the engine status of the last move, ENGINE_TRICK or
+ *         ENGINE_GAMEOVER unless a player did not make a valid move.
+ */
+int play_sim_round(PlayerGame *players, EngineGame *engine) {
+    int count = engine->playerCount;
+    EngineStatus status = ENGINE_OK;
+    while (status == ENGINE_OK) {
+        int mover = engine->toMove;
+        if (!players[mover].moved) {
+            return ENGINE_NOT_TURN;
+        }
+        players[mover].moved = 0;
+        Card card = players[mover].chosen;
+        status = engine_play(engine, mover, card);
+        if (status > ENGINE_GAMEOVER) {
+            return status;
+        }
+        for (int i = 0; i < count; i++) {
+            if (i != mover && apply_played(&players[i], mover, card) != 0) {
+                return ENGINE_NOT_TURN;
+            }
+        }
+    }
+    return status;
+}
+
+/**
+ * Function to play game number k of the seed from the deal to the final
+ * scores, entirely in memory.
+ * @param sim - settings of the simulation.
+ * @param players - every player of the game, ready for a new game.
+ * @param engine - engine to play the game in.
+ * @param deck - deck with room for the shoe, see dealgen_shoe_size.
+ * @param number - game number, which decides the deal.
+ * @return 0 - game finished, final scores are in the engine
+ *         6 - a player did not make a valid move.
+ */
+int play_sim_game(Sim *sim, PlayerGame *players, EngineGame *engine,
+        Deck *deck, long number) {
+    dealgen_deal(sim->seed, number, &sim->deal, deck);
+    engine_deal(engine, deck->contents, sim->handSize);
+    for (int i = 0; i < sim->playerCount; i++) {
+        // every card of the last game has been played, as for NEWGAME
+        if (players[i].handSize == 0) {
+            apply_newgame(&players[i], sim->handSize);
+        }
+        players[i].hand = engine->hands[i];
+    }
+    EngineStatus status = ENGINE_TRICK;
+    while (status == ENGINE_TRICK) {
+        // NEWROUND, on which the lead player moves
+        for (int i = 0; i < sim->playerCount; i++) {
+            if (apply_newround(&players[i], engine->leadPlayer) != 0) {
+                return SIM_BADMOVE;
+            }
+        }
+        status = play_sim_round(players, engine);
+    }
+    return status == ENGINE_GAMEOVER ? SIM_OK : SIM_BADMOVE;
+}
+
+/**
+ * Function run by each worker thread, claiming games in chunks until none
+ * are left. Each worker has its own players, engine and stats, so nothing is
+ * shared but the game counter.
+ * @param arg - the worker.
+ * @return NULL.
+ */
+void *run_worker(void *arg) {
+    Worker *worker = arg;
+    Sim *sim = worker->sim;
+    PlayerGame *players = malloc(sizeof(PlayerGame) * sim->playerCount);
+    worker->status = SIM_OK;
+    for (int i = 0; i < sim->playerCount; i++) {
+        // a seat which cannot be set up cannot play its strategy
+        if (init_sim_player(sim, &players[i], i) != DONE) {
+            worker->status = SIM_STRATEGY;
+        }
+    }
+    EngineGame engine;
+    engine_init(&engine, sim->playerCount, sim->threshold);
+    Deck deck = {0, 0, malloc(sizeof(Card) * dealgen_shoe_size(&sim->deal))};
+
+    long start;
+    while (worker->status == SIM_OK && (start = __atomic_fetch_add(
+            &sim->nextGame, SIM_CHUNK, __ATOMIC_RELAXED)) < sim->games) {
+        long end = start + SIM_CHUNK < sim->games
+                ? start + SIM_CHUNK : sim->games;
+        for (long k = start; k < end; k++) {
+            worker->status = play_sim_game(sim, players, &engine, &deck, k);
+            if (worker->status != SIM_OK) {
+                break;
+            }
+            record_game(&worker->stats, &engine);
+        }
+    }
+
+    engine_free(&engine);
+    free(deck.contents);
+    for (int i = 0; i < sim->playerCount; i++) {
+        release_plugin(&players[i]);
+        arena_free(&players[i].scratch);
+        arena_free(&players[i].storage);
+    }
+    free(players);
+    return NULL;
+}
+
+/**
+ * Function to run every game across the worker threads and merge the stats
+ * of each worker once they are done.
+ * @param sim - settings of the simulation.
+ * @param total - stats to fill, already set up.
+ * @return 0 - all games played
+ *         6 - a player did not make a valid move.
+ */
+SimStatus run_sim(Sim *sim, SimStats *total) {
+    Worker *workers = malloc(sizeof(Worker) * sim->threads);
+    for (int i = 0; i < sim->threads; i++) {
+        workers[i].sim = sim;
+        init_stats(&workers[i].stats, sim->playerCount, sim->deal.cards);
+        pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]);
+    }
+    SimStatus status = SIM_OK;
+    for (int i = 0; i < sim->threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].status != SIM_OK) {
+            status = workers[i].status;
+        }
+        merge_stats(total, &workers[i].stats, sim->playerCount);
+        free_stats(&workers[i].stats);
+    }
+    free(workers);
+    return status;
+}
+
+/**
+ * Function to print the results of each seat and the distribution of final
+ * scores to stdout.
+ * @param sim - settings of the simulation.
+ * @param total - merged stats of every worker.
+ */
+void print_stats(Sim *sim, SimStats *total) {
+    int count = sim->playerCount;
+    printf("Games=%ld Players=%d Threshold=%d Seed=%llu Cards=%d\n",
+            total->games, count, sim->threshold,
+            (unsigned long long) sim->seed, sim->deal.cards);
+    printf("Seat Strategy Mean Wins Min Median Max\n");
+    int range = total->scoreRange;
+    int offset = total->scoreOffset;
+    for (int i = 0; i < count; i++) {
+        long *scores = total->histogram + i * range;
+        int min = range, median = -1, max = 0;
+        long seen = 0;
+        for (int s = 0; s < range; s++) {
+            if (scores[s] == 0) {
+                continue;
+            }
+            min = s < min ? s : min;
+            max = s;
+            seen += scores[s];
+            if (median < 0 && seen * 2 >= total->games) {
+                median = s;
+            }
+        }
+        printf("%d %s %.3f %.2f%% %d %d %d\n", i, sim->names[i],
+                (double) total->scoreSum[i] / total->games,
+                100.0 * total->wins[i] / total->games,
+                min - offset, median - offset,
+                max - offset);
+    }
+
+    // games ending on each score, only for scores that happened
+    printf("Score");
+    for (int i = 0; i < count; i++) {
+        printf(" %d", i);
+    }
+    printf("\n");
+    for (int s = 0; s < range; s++) {
+        long any = 0;
+        for (int i = 0; i < count; i++) {
+            any += total->histogram[i * range + s];
+        }
+        if (any == 0) {
+            continue;
+        }
+        printf("%d", s - offset);
+        for (int i = 0; i < count; i++) {
+            printf(" %ld", total->histogram[i * range + s]);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * Function acting as entry point for the program.
+ * @param argc - number of arguments received at command line
+ * @param argv - array of strings representing arguments received.
+ * @return 0 - normal exit
+ *         1 - usage error
+ *         2 - threshold < 2 or not a number
+ *         3 - invalid deck spec
+ *         4 - less than P cards in each deal
+ *         5 - unknown strategy name or plug-in that does not load
+ *         6 - a strategy made an invalid move.
+ */
+int main(int argc, char **argv) {
+    Sim sim;
+    int parseStatus = parse_sim(argc, argv, &sim);
+    if (parseStatus != SIM_OK) {
+        return parseStatus;
+    }
+    SimStats total;
+    init_stats(&total, sim.playerCount, sim.deal.cards);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SimStatus status = run_sim(&sim, &total);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (status != SIM_OK) {
+        return show_sim_message(status);
+    }
+    print_stats(&sim, &total);
+    // timing goes to stderr so the results are the same on every run
+    double seconds = (end.tv_sec - start.tv_sec)
+            + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Threads=%d Seconds=%.3f Games/sec=%.0f\n", sim.threads,
+            seconds, total.games / seconds);
+    free_stats(&total);
+    free(sim.plugins);
+    return SIM_OK;
+}
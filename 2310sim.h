@@ -0,0 +1,82 @@
+#include "shared.h"
+#include "engine.h"
+#include "dealgen.h"
+#include "plugin.h"
+#include <pthread.h>
+
+#ifndef SIM_H
+#define SIM_H
+
+// games a worker claims from the shared counter at a time
+#define SIM_CHUNK 256
+
+/* enum for sim exit status */
+typedef enum {
+    SIM_OK = 0,
+    SIM_USAGE = 1,
+    SIM_THRESHOLD = 2,
+    SIM_DECKSPEC = 3,
+    SIM_SHORTDECK = 4,
+    SIM_STRATEGY = 5,
+    SIM_BADMOVE = 6
+} SimStatus;
+
+// struct for the settings shared by every worker
+typedef struct {
+    long games;
+    int threads;
+    uint64_t seed;
+    DealSpec deal; // what each deal holds.
+    int threshold;
+    int playerCount;
+    int handSize;
+    char **names; // strategy name of each seat.
+    const StrategyPlugin **plugins; // strategy of each seat.
+    long nextGame; // next game not yet claimed by a worker.
+} Sim;
+
+// struct for the results gathered by one worker
+typedef struct {
+    long games;
+    long *wins; // [seat], ties for the top score count for each seat.
+    long *scoreSum; // [seat]
+    // final scores are n +/- d, so they lie within a deal's size of 0
+    int scoreOffset; // cards in each deal.
+    int scoreRange; // 2 * scoreOffset + 1.
+    long *histogram; // [seat * scoreRange + score + scoreOffset]
+} SimStats;
+
+// struct for a worker thread
+typedef struct {
+    Sim *sim;
+    pthread_t thread;
+    SimStats stats;
+    SimStatus status;
+} Worker;
+
+SimStatus show_sim_message(SimStatus s);
+
+int parse_sim(int argc, char **argv, Sim *sim);
+
+void init_stats(SimStats *stats, int playerCount, int dealCards);
+
+void free_stats(SimStats *stats);
+
+void record_game(SimStats *stats, EngineGame *engine);
+
+void merge_stats(SimStats *total, SimStats *part, int playerCount);
+
+int init_sim_player(Sim *sim, PlayerGame *player, int id);
+
+int play_sim_round(PlayerGame *players, EngineGame *engine);
+
+int play_sim_game(Sim *sim, PlayerGame *players, EngineGame *engine,
+        Deck *deck, long number);
+
+void *run_worker(void *arg);
+
+SimStatus run_sim(Sim *sim, SimStats *total);
+
+void print_stats(Sim *sim, SimStats *total);
+
+#endif
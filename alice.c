@@ -0,0 +1,49 @@
+#include "2310alice.h"
+
+/**
+ * Function to handle alice's move set & decisions.
+ * @param view what alice can see of the game.
+ * @return the code of the card to play.
+ */
+int alice_lead_move(const StrategyView *view) {
+    // highest card of the first suit held, searching in this order
+    int suit = card_set_first_suit(view->hand, "SCDH");
+    return card_code(card_at(suit, card_set_highest(view->hand, suit)));
+}
+
+/**
+ * Function to handle the 'default' alice move (last option)
+ * @param view what alice can see of the game.
+ * @return the code of the card to play.
+ */
+int alice_default_move(const StrategyView *view) {
+    // highest card of the first suit held, searching in this order
+    int suit = card_set_first_suit(view->hand, "DHSC");
+    return card_code(card_at(suit, card_set_highest(view->hand, suit)));
+}
+
+
+/**
+ * Strategy for alice movements.
+ * @param view what alice can see of the game.
+ * @return the code of the card to play.
+ */
+int alice_choose(const StrategyView *view) {
+    //if lead player.
+    if (view->leadPlayer == view->myID) {
+        return alice_lead_move(view);
+    }
+
+    //if card in lead suit
+    if (card_set_suit(view->hand, view->leadSuit) != 0) {
+        return card_code(card_at(view->leadSuit,
+                card_set_lowest(view->hand, view->leadSuit)));
+    }
+
+    //default move
+    return alice_default_move(view);
+}
+
+// alice as a plug-in, built into 2310alice and 2310sim and as alice.so
+const StrategyPlugin alicePlugin = {STRATEGY_ABI_VERSION, "alice", NULL, NULL,
+        alice_choose};
@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include "arena.h"
+
+/**
+ * Function to set up an arena with a block of the given size.
+ * @param arena - arena to set up.
+ * @param size - number of bytes the arena can hand out between resets.
+ * @return 1 if the block was allocated, 0 if not.
+ */
+int arena_init(Arena *arena, size_t size) {
+    arena->base = malloc(size);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+/**
+ * Function to take storage from an arena. The storage is valid until the
+ * arena is next reset.
+ * @param arena - arena to allocate from.
+ * @param bytes - number of bytes needed.
+ * @return pointer to the storage, NULL if the arena is full.
+ */
+void *arena_alloc(Arena *arena, size_t bytes) {
+    // round up so the next allocation stays aligned
+    size_t rounded = (bytes + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    if (rounded > arena->size - arena->used) {
+        return NULL;
+    }
+    void *block = arena->base + arena->used;
+    arena->used += rounded;
+    return block;
+}
+
+/**
+ * Function to release everything allocated from an arena, keeping the block.
+ * @param arena - arena to reset.
+ */
+void arena_reset(Arena *arena) {
+    arena->used = 0;
+}
+
+/**
+ * Function to give the arena's block back to the heap.
+ * @param arena - arena to free.
+ */
+void arena_free(Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,30 @@
+#include <stddef.h>
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * Bump allocator over one block of memory. Allocations are never freed one at
+ * a time, the whole arena is reset (or freed) at once, so storage with a
+ * shared lifetime (a message, a game) costs no heap traffic once set up.
+ */
+
+// every allocation starts on a multiple of this many bytes
+#define ARENA_ALIGN 16
+
+// struct for an arena
+typedef struct {
+    char *base;
+    size_t size; // bytes in the block
+    size_t used; // bytes handed out since the last reset
+} Arena;
+
+int arena_init(Arena *arena, size_t size);
+
+void *arena_alloc(Arena *arena, size_t bytes);
+
+void arena_reset(Arena *arena);
+
+void arena_free(Arena *arena);
+
+#endif
@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/*
+ * End to end benchmark of 2310hub with real alice and bob players. The hub
+ * is started with this program as every player. In that role it is a proxy:
+ * it runs the real player and passes bytes both ways, timing each PLAY
+ * against the last hub write before it. Results go into a shared mapping
+ * rather than being written at exit, because the hub kills its players.
+ */
+
+// environment variables telling a proxy where to record and what to run
+#define E2E_STATS_ENV "E2E_STATS"
+#define E2E_PLAYERS_ENV "E2E_PLAYERS"
+
+#define E2E_MAX_PLAYERS 64
+
+// latency bucket b holds round trips of 2^b to 2^(b+1) - 1 nanoseconds
+#define E2E_BUCKETS 40
+
+// struct for the results proxies record, shared with the harness
+typedef struct {
+    uint64_t firstHand[E2E_MAX_PLAYERS]; // when each player got hub data
+    uint64_t buckets[E2E_BUCKETS];
+    uint64_t plays;
+} E2EShared;
+
+// struct for the harness settings
+typedef struct {
+    int runs;
+    int games;
+    int maxPlayers;
+    int hands[16];
+    int handCount;
+    int binary;
+    char *hub;
+    char *self; // path of this program, used as every player
+} E2EConfig;
+
+/**
+ * Function to get the time from the monotonic clock, which every process on
+ * the machine shares.
+ * @return the time in nanoseconds.
+ */
+uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * Function to find the latency bucket of a round trip.
+ * @param nanoseconds - the round trip.
+ * @return the bucket, the floor of its base 2 log.
+ */
+int latency_bucket(uint64_t nanoseconds) {
+    int bucket = nanoseconds ? 63 - __builtin_clzll(nanoseconds) : 0;
+    return bucket < E2E_BUCKETS ? bucket : E2E_BUCKETS - 1;
+}
+
+/**
+ * Function to write all of a buffer, retrying short writes.
+ * @param fd - file descriptor to write to.
+ * @param data - bytes to write.
+ * @param length - number of bytes.
+ * @return 1 if everything was written, 0 if not.
+ */
+int write_all(int fd, const char *data, ssize_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written <= 0) {
+            return 0;
+        }
+        data += written;
+        length -= written;
+    }
+    return 1;
+}
+
+/**
+ * Function to map the shared results file named in the environment.
+ * @return the mapping, NULL if it could not be made.
+ */
+E2EShared *map_shared(void) {
+    int fd = open(getenv(E2E_STATS_ENV), O_RDWR);
+    if (fd < 0) {
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(E2EShared), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+/**
+ * Function to start the real player for a seat, talking over two pipes.
+ * @param argv - arguments the hub gave us, passed on unchanged.
+ * @param toPlayer - where to store the end we write the player's input to.
+ * @param fromPlayer - where to store the end we read the player's output from.
+ * @return 1 if the player was started, 0 if not.
+ */
+int start_player(char **argv, int *toPlayer, int *fromPlayer) {
+    // E2E_PLAYERS is one path per seat, separated by ':'
+    char *paths = strdup(getenv(E2E_PLAYERS_ENV));
+    char *path = strtok(paths, ":");
+    for (int i = 0; i < atoi(argv[2]) && path; i++) {
+        path = strtok(NULL, ":");
+    }
+    int in[2], out[2];
+    if (!path || pipe(in) < 0 || pipe(out) < 0) {
+        return 0;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        return 0;
+    } else if (pid == 0) {
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        close(in[0]);
+        close(in[1]);
+        close(out[0]);
+        close(out[1]);
+        argv[0] = path;
+        execv(path, argv);
+        _exit(5);
+    }
+    close(in[0]);
+    close(out[1]);
+    *toPlayer = in[1];
+    *fromPlayer = out[0];
+    return 1;
+}
+
+/**
+ * Function to act as a player for the hub, passing everything through to
+ * the real player and timing its moves. A move is a line after the '@'
+ * handshake, or a two byte record once the player answered "@B".
+ * @param argv - arguments from the hub.
+ * @return 0 once either side closes, 5 if the real player could not start.
+ */
+int run_proxy(char **argv) {
+    E2EShared *shared = map_shared();
+    int toPlayer, fromPlayer;
+    if (!shared || !start_player(argv, &toPlayer, &fromPlayer)) {
+        return 5;
+    }
+    int id = atoi(argv[2]) % E2E_MAX_PLAYERS;
+    uint64_t lastHub = 0;
+    int handshake = 0; // bytes of the handshake seen, 2 once it is over
+    int binary = 0;
+    int recordBytes = 0;
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0},
+            {fromPlayer, POLLIN, 0}};
+    char buffer[4096];
+    while (poll(fds, 2, -1) > 0) {
+        // a move already waiting was made before any hub data read now
+        if (fds[1].revents) {
+            ssize_t got = read(fromPlayer, buffer, sizeof(buffer));
+            if (got <= 0) {
+                return 0;
+            }
+            uint64_t arrived = now_ns();
+            for (ssize_t i = 0; i < got; i++) {
+                int moved = 0;
+                if (handshake == 0) {
+                    handshake = buffer[i] == '@';
+                    continue;
+                } else if (handshake == 1) {
+                    handshake = 2;
+                    if (buffer[i] == 'B') {
+                        binary = 1;
+                        continue;
+                    }
+                }
+                if (binary) {
+                    recordBytes = (recordBytes + 1) % 2;
+                    moved = recordBytes == 0;
+                } else {
+                    moved = buffer[i] == '\n';
+                }
+                if (moved && lastHub) {
+                    __atomic_fetch_add(&shared->buckets[
+                            latency_bucket(arrived - lastHub)], 1,
+                            __ATOMIC_RELAXED);
+                    __atomic_fetch_add(&shared->plays, 1, __ATOMIC_RELAXED);
+                }
+            }
+            if (!write_all(STDOUT_FILENO, buffer, got)) {
+                return 0;
+            }
+        }
+        if (fds[0].revents) {
+            ssize_t got = read(STDIN_FILENO, buffer, sizeof(buffer));
+            lastHub = now_ns();
+            if (got <= 0 || !write_all(toPlayer, buffer, got)) {
+                return 0;
+            }
+            if (!shared->firstHand[id]) {
+                shared->firstHand[id] = lastHub;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to run the hub once for a number of games and wait for it.
+ * @param config - harness settings.
+ * @param players - number of players.
+ * @param hand - hand size.
+ * @param seed - seed for the hub's deals.
+ * @param statsPath - file the proxies record into.
+ * @param launched - where to store when the hub was started.
+ * @return the hub's exit status, -1 if it could not be run.
+ */
+int run_hub(E2EConfig *config, int players, int hand, int seed,
+        const char *statsPath, uint64_t *launched) {
+    char games[16], seedArg[16], spec[16];
+    sprintf(games, "%d", config->games);
+    sprintf(seedArg, "%d", seed);
+    sprintf(spec, "%d", players * hand);
+    char *args[12 + E2E_MAX_PLAYERS];
+    int count = 0;
+    args[count++] = config->hub;
+    if (config->binary) {
+        args[count++] = "--binary";
+    }
+    char *options[] = {"--games", games, "--seed", seedArg, "--deck-spec",
+            spec, "2"};
+    for (int i = 0; i < 7; i++) {
+        args[count++] = options[i];
+    }
+    for (int i = 0; i < players; i++) {
+        args[count++] = config->self;
+    }
+    args[count] = NULL;
+
+    *launched = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    } else if (pid == 0) {
+        // the hub's results are not needed, only how long it takes
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        setenv(E2E_STATS_ENV, statsPath, 1);
+        execv(config->hub, args);
+        _exit(5);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/**
+ * Function to find a percentile of a latency histogram.
+ * @param buckets - the histogram.
+ * @param total - number of round trips in it.
+ * @param percent - percentile wanted.
+ * @return upper bound of the bucket holding it, in microseconds.
+ */
+double percentile_us(const uint64_t *buckets, uint64_t total, double percent) {
+    uint64_t seen = 0;
+    for (int b = 0; b < E2E_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen > 0 && seen >= total * percent / 100) {
+            return (double) ((uint64_t) 2 << b) / 1000;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to benchmark one player count and hand size over every run,
+ * printing one row of the scaling table.
+ * @param config - harness settings.
+ * @param players - number of players.
+ * @param hand - hand size.
+ * @param total - histogram of every round trip so far, added to.
+ * @return 0 if every run finished, otherwise the hub's failing status.
+ */
+int run_config(E2EConfig *config, int players, int hand, uint64_t *total) {
+    char statsPath[] = "/tmp/2310e2eXXXXXX";
+    int fd = mkstemp(statsPath);
+    if (fd < 0 || ftruncate(fd, sizeof(E2EShared)) < 0) {
+        return -1;
+    }
+    E2EShared *shared = mmap(NULL, sizeof(E2EShared), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    close(fd);
+    uint64_t buckets[E2E_BUCKETS] = {0};
+    double seconds = 0, startup = 0, worstStartup = 0;
+    int status = 0;
+    for (int run = 0; run < config->runs && status == 0; run++) {
+        memset(shared, 0, sizeof(E2EShared));
+        uint64_t launched;
+        status = run_hub(config, players, hand, run, statsPath, &launched);
+        seconds += (now_ns() - launched) / 1e9;
+        // the game can start once the last player has its hand
+        uint64_t lastHand = launched;
+        for (int i = 0; i < players; i++) {
+            if (shared->firstHand[i] > lastHand) {
+                lastHand = shared->firstHand[i];
+            }
+        }
+        double runStartup = (lastHand - launched) / 1e3;
+        startup += runStartup;
+        worstStartup = runStartup > worstStartup ? runStartup : worstStartup;
+        for (int b = 0; b < E2E_BUCKETS; b++) {
+            buckets[b] += shared->buckets[b];
+        }
+    }
+    munmap(shared, sizeof(E2EShared));
+    unlink(statsPath);
+    if (status != 0) {
+        fprintf(stderr, "2310hub exited with %d for %d players, hand %d\n",
+                status, players, hand);
+        return status;
+    }
+
+    uint64_t plays = 0;
+    for (int b = 0; b < E2E_BUCKETS; b++) {
+        plays += buckets[b];
+        total[b] += buckets[b];
+    }
+    printf("%7d %4d %10.1f %11.1f %11.1f %8.1f %8.1f %8.1f\n", players, hand,
+            config->runs * config->games / seconds, startup / config->runs,
+            worstStartup, percentile_us(buckets, plays, 50),
+            percentile_us(buckets, plays, 99),
+            percentile_us(buckets, plays, 100));
+    fflush(stdout);
+    return 0;
+}
+
+/**
+ * Function to parse the harness options.
+ * @param argc - number of arguments supplied
+ * @param argv - arguments supplied at command line.
+ * @param config - settings to fill in.
+ * @return 1 if the options are valid, 0 if not.
+ */
+int parse_e2e(int argc, char **argv, E2EConfig *config) {
+    static struct option longOptions[] = {
+            {"runs", required_argument, 0, 'r'},
+            {"games", required_argument, 0, 'g'},
+            {"max-players", required_argument, 0, 'p'},
+            {"hands", required_argument, 0, 'h'},
+            {"binary", no_argument, 0, 'b'},
+            {"hub", required_argument, 0, 'u'},
+            {0, 0, 0, 0}};
+    config->runs = 5;
+    config->games = 20;
+    config->maxPlayers = 6;
+    config->handCount = 0;
+    config->binary = 0;
+    config->hub = "./2310hub";
+    char defaultHands[] = "1,5,10";
+    char *hands = defaultHands;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, 0)) != -1) {
+        if (opt == 'r') {
+            config->runs = atoi(optarg);
+        } else if (opt == 'g') {
+            config->games = atoi(optarg);
+        } else if (opt == 'p') {
+            config->maxPlayers = atoi(optarg);
+        } else if (opt == 'h') {
+            hands = optarg;
+        } else if (opt == 'b') {
+            config->binary = 1;
+        } else if (opt == 'u') {
+            config->hub = optarg;
+        } else {
+            return 0;
+        }
+    }
+    for (char *hand = strtok(hands, ","); hand && config->handCount < 16;
+            hand = strtok(NULL, ",")) {
+        config->hands[config->handCount++] = atoi(hand);
+    }
+    return optind == argc && config->runs > 0 && config->games > 0
+            && config->maxPlayers >= 2
+            && config->maxPlayers <= E2E_MAX_PLAYERS
+            && config->handCount > 0;
+}
+
+/**
+ * Function acting as entry point for the program, either the harness or, when
+ * started by the hub, a proxy player.
+ * @param argc - number of arguments received at command line
+ * @param argv - array of strings representing arguments received.
+ * @return 0 - normal exit
+ *         1 - usage error
+ *         otherwise the status of a hub run which failed.
+ */
+int main(int argc, char **argv) {
+    if (getenv(E2E_STATS_ENV)) {
+        return run_proxy(argv);
+    }
+    E2EConfig config;
+    if (!parse_e2e(argc, argv, &config)) {
+        fprintf(stderr, "Usage: e2e [--runs R] [--games G] [--max-players N]"
+                " [--hands h1,h2] [--binary] [--hub path]\n");
+        return 1;
+    }
+    // players alternate alice and bob, by seat
+    char players[E2E_MAX_PLAYERS * (PATH_MAX + 1)] = "";
+    // the players are links to the hub, and are run by their own name
+    char alice[PATH_MAX], bob[PATH_MAX], self[PATH_MAX];
+    char here[PATH_MAX - 16];
+    if (!getcwd(here, sizeof(here)) || access("./2310alice", X_OK)
+            || access("./2310bob", X_OK)
+            || !realpath("/proc/self/exe", self)) {
+        fprintf(stderr, "Run from the directory holding 2310alice and "
+                "2310bob\n");
+        return 1;
+    }
+    sprintf(alice, "%s/2310alice", here);
+    sprintf(bob, "%s/2310bob", here);
+    config.self = self;
+    for (int i = 0; i < config.maxPlayers; i++) {
+        strcat(players, i ? ":" : "");
+        strcat(players, i % 2 ? bob : alice);
+    }
+    setenv(E2E_PLAYERS_ENV, players, 1);
+
+    printf("players hand  games/sec  startup_us  worst_us   p50_us   p99_us"
+            "   max_us\n");
+    uint64_t total[E2E_BUCKETS] = {0};
+    for (int players = 2; players <= config.maxPlayers; players++) {
+        for (int h = 0; h < config.handCount; h++) {
+            // generated deals come from the 60 card standard deck
+            if (config.hands[h] < 1 || players * config.hands[h] > 60) {
+                continue;
+            }
+            int status = run_config(&config, players, config.hands[h], total);
+            if (status != 0) {
+                return status;
+            }
+        }
+    }
+
+    // every PLAY round trip across the sweep
+    printf("\nround trip (us)      count\n");
+    for (int b = 0; b < E2E_BUCKETS; b++) {
+        if (total[b]) {
+            printf("%8.1f - %-8.1f %8llu\n", (double) ((uint64_t) 1 << b)
+                    / 1000, (double) ((uint64_t) 2 << b) / 1000,
+                    (unsigned long long) total[b]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "2310hub.h"
+#include "2310alice.h"
+#include "2310bob.h"
+#include "2310carol.h"
+#include "dealgen.h"
+
+/*
+ * Microbenchmarks for the hot paths of the hub and players. Each reports the
+ * time and number of heap allocations per call. Allocations are counted by
+ * linking with -Wl,--wrap=malloc (and calloc, realloc), so only calls made
+ * by the repo's own code are seen.
+ */
+
+// number of different inputs each benchmark cycles through
+#define BENCH_INPUTS 64
+
+// hand size used throughout, a 60 card deck between four players
+#define BENCH_PLAYERS 4
+#define BENCH_HAND 15
+
+// room for any message the benchmarks build
+#define BENCH_LINE 128
+
+static long allocations;
+static struct timespec started;
+static long allocationsAtStart;
+static volatile long sink; // results go here so no call is optimised away
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+/**
+ * Function to count a call to malloc before making it.
+ * @param size - bytes wanted.
+ * @return the storage.
+ */
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+/**
+ * Function to count a call to calloc before making it.
+ * @param count - number of elements wanted.
+ * @param size - bytes in each element.
+ * @return the storage.
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+/**
+ * Function to count a call to realloc before making it.
+ * @param pointer - storage to resize.
+ * @param size - bytes wanted.
+ * @return the storage.
+ */
+void *__wrap_realloc(void *pointer, size_t size) {
+    allocations++;
+    return __real_realloc(pointer, size);
+}
+
+/**
+ * Function to start timing a benchmark, once its setup is done.
+ */
+void bench_start(void) {
+    allocationsAtStart = allocations;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+}
+
+/**
+ * Function to stop timing a benchmark and print its results.
+ * @param name - name of the benchmark.
+ * @param iterations - number of calls made since bench_start.
+ */
+void bench_stop(const char *name, long iterations) {
+    struct timespec stopped;
+    clock_gettime(CLOCK_MONOTONIC, &stopped);
+    double nanoseconds = (stopped.tv_sec - started.tv_sec) * 1e9
+            + (stopped.tv_nsec - started.tv_nsec);
+    printf("%-28s %10.1f %10.2f\n", name, nanoseconds / iterations,
+            (double) (allocations - allocationsAtStart) / iterations);
+}
+
+/**
+ * Function to make the random deals the benchmarks draw their inputs from.
+ * @param decks - BENCH_INPUTS decks to fill, each with room for a deal.
+ */
+void make_deals(Deck *decks) {
+    DealSpec deal;
+    dealgen_spec(DEALGEN_DEFAULT_SPEC, &deal);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        decks[i].contents = malloc(sizeof(Card) * DEALGEN_STANDARD);
+        dealgen_deal(2310, i, &deal, &decks[i]);
+    }
+}
+
+/**
+ * Function to set up a player as its program would after parsing arguments.
+ * Moves are collected in memory rather than printed.
+ * @param game - player to set up.
+ * @param id - seat of the player.
+ */
+void make_player(PlayerGame *game, int id) {
+    memset(game, 0, sizeof(PlayerGame));
+    game->playerCount = BENCH_PLAYERS;
+    game->myID = id;
+    game->threshold = 2;
+    game->handSize = BENCH_HAND;
+    if (init_expected(game) != DONE) {
+        exit(1);
+    }
+    game->simulated = 1;
+}
+
+/**
+ * Function to set up a hub game with its engine dealt and player output
+ * buffers ready, but no player processes.
+ * @param game - game to set up.
+ * @param deck - deck to deal from.
+ */
+void make_hub(Game *game, Deck *deck) {
+    memset(game, 0, sizeof(Game));
+    game->playerCount = BENCH_PLAYERS;
+    game->threshold = 2;
+    game->numCardsToDeal = BENCH_HAND;
+    game->source = *deck;
+    game->players = calloc(BENCH_PLAYERS, sizeof(Player));
+    for (int i = 0; i < BENCH_PLAYERS; i++) {
+        game->players[i].outputSize = 256;
+        game->players[i].output = malloc(256);
+        game->players[i].tag = -1;
+    }
+    engine_init(&game->engine, BENCH_PLAYERS, game->threshold);
+    engine_deal(&game->engine, deck->contents, BENCH_HAND);
+}
+
+/**
+ * Function to build the HAND message for the first hand of a deck.
+ * @param deck - deck to take the hand from.
+ * @param message - buffer to write the message into.
+ */
+void make_hand_message(Deck *deck, char *message) {
+    int length = sprintf(message, "HAND%d", BENCH_HAND);
+    for (int i = 0; i < BENCH_HAND; i++) {
+        message[length++] = ',';
+        length += card_to_text(deck->contents[i], message + length);
+    }
+    strcpy(message + length, "\n");
+}
+
+/**
+ * Function to time decode_hand on random hands.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_decode_hand(Deck *decks, long iterations) {
+    char messages[BENCH_INPUTS][BENCH_LINE];
+    char input[BENCH_LINE];
+    PlayerGame game;
+    make_player(&game, 0);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        make_hand_message(&decks[i], messages[i]);
+    }
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        // decoding writes into the line, as fgets would give a fresh one
+        strcpy(input, messages[i % BENCH_INPUTS]);
+        sink += decode_hand(input, &game);
+        arena_reset(&game.scratch);
+    }
+    bench_stop("decode_hand", iterations);
+}
+
+/**
+ * Function to time decode_played for a player who does not move in response.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_decode_played(Deck *decks, long iterations) {
+    char messages[BENCH_INPUTS][BENCH_LINE];
+    char input[BENCH_LINE];
+    PlayerGame game;
+    // the last seat, so PLAYED0 is never followed by our own move
+    make_player(&game, BENCH_PLAYERS - 1);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        char text[CARD_TEXT_SIZE];
+        sprintf(messages[i], "PLAYED0,%.*s\n",
+                card_to_text(decks[i].contents[0], text), text);
+    }
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        game.leadPlayer = 0;
+        game.lastPlayer = BENCH_PLAYERS - 1;
+        game.orderPos = 0;
+        game.cardPos = 0;
+        game.dPlayedRound = 0;
+        strcpy(input, messages[i % BENCH_INPUTS]);
+        sink += decode_played(input, &game);
+        arena_reset(&game.scratch);
+    }
+    bench_stop("decode_played", iterations);
+}
+
+/**
+ * Function to time process_input, message type dispatch and ordering checks
+ * included, on HAND messages.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_process_input(Deck *decks, long iterations) {
+    char messages[BENCH_INPUTS][BENCH_LINE];
+    char input[BENCH_LINE];
+    PlayerGame game;
+    make_player(&game, 0);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        make_hand_message(&decks[i], messages[i]);
+    }
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        set_expected(&game, PROTO_START);
+        strcpy(input, messages[i % BENCH_INPUTS]);
+        sink += process_input(input, &game);
+        arena_reset(&game.scratch);
+    }
+    bench_stop("process_input (HAND)", iterations);
+}
+
+/**
+ * Function to time validate_play on valid PLAY messages.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_validate_play(Deck *decks, long iterations) {
+    char messages[BENCH_INPUTS][BENCH_LINE];
+    Game game;
+    make_hub(&game, &decks[0]);
+    // cards from player 0's hand, so every play is valid
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        Card card = decks[0].contents[i % BENCH_HAND];
+        char text[CARD_TEXT_SIZE];
+        sprintf(messages[i], "PLAY%.*s\n", card_to_text(card, text), text);
+    }
+    Card card;
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        sink += validate_play(&game, messages[i % BENCH_INPUTS], 0, &card);
+    }
+    bench_stop("validate_play", iterations);
+}
+
+/**
+ * Function to time check_card_in_hand on random cards, held or not.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_check_card_in_hand(Deck *decks, long iterations) {
+    Game game;
+    make_hub(&game, &decks[0]);
+    // a card not held prints an error, so silence stderr while timing
+    FILE *saved = stderr;
+    stderr = fopen("/dev/null", "w");
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        Card card = decks[1].contents[i % DEALGEN_STANDARD];
+        sink += check_card_in_hand(&game, &card, i % BENCH_PLAYERS);
+    }
+    bench_stop("check_card_in_hand", iterations);
+    fclose(stderr);
+    stderr = saved;
+}
+
+/**
+ * Function to time building the HAND message in deal_card_to_player.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ * @param binary - 1 to build binary records instead of text.
+ */
+void bench_deal_card_to_player(Deck *decks, long iterations, int binary) {
+    Game game;
+    make_hub(&game, &decks[0]);
+    for (int i = 0; i < BENCH_PLAYERS; i++) {
+        game.players[i].binary = binary;
+    }
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        int id = i % BENCH_PLAYERS;
+        // the message is flushed after each deal in the hub
+        game.players[id].outputLength = 0;
+        sink += deal_card_to_player(&game, id);
+    }
+    bench_stop(binary ? "deal_card_to_player (bin)"
+            : "deal_card_to_player (text)", iterations);
+}
+
+/**
+ * Function to time scoring a trick, which replaced calculate_scores when the
+ * rules moved into the engine.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ */
+void bench_resolve_trick(Deck *decks, long iterations) {
+    EngineGame engine;
+    engine_init(&engine, BENCH_PLAYERS, 2);
+    engine_deal(&engine, decks[0].contents, BENCH_HAND);
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        Deck *deck = &decks[i % BENCH_INPUTS];
+        memcpy(engine.cardsByRound, deck->contents,
+                sizeof(Card) * BENCH_PLAYERS);
+        engine.leadSuit = deck->contents[0].suit;
+        engine_resolve_trick(&engine);
+        sink += engine.leadPlayer;
+    }
+    bench_stop("engine_resolve_trick", iterations);
+    engine_free(&engine);
+}
+
+/**
+ * Function to time a strategy choosing a card from random hands, as leader,
+ * follower and with D cards about.
+ * @param decks - random deals.
+ * @param iterations - number of calls to time.
+ * @param name - name of the strategy.
+ * @param plugin - the strategy.
+ */
+void bench_strategy(Deck *decks, long iterations, const char *name,
+        const StrategyPlugin *plugin) {
+    CardSet hands[BENCH_INPUTS];
+    PlayerGame game;
+    make_player(&game, 1);
+    use_plugin(&game, plugin);
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        hands[i] = card_set_empty();
+        for (int j = 0; j < BENCH_HAND; j++) {
+            card_set_add(&hands[i], decks[i].contents[j]);
+        }
+    }
+    bench_start();
+    for (long i = 0; i < iterations; i++) {
+        game.hand.held = hands[i % BENCH_INPUTS];
+        game.handSize = BENCH_HAND;
+        game.cardPos = 0;
+        game.leadPlayer = i & 1;
+        game.leadSuit = "SCDH"[(i >> 1) & 3];
+        game.dPlayedRound = (i >> 3) & 1;
+        game.dPlayerNumber[0] = (i >> 4) & 1 ? game.threshold : 0;
+        sink += game.playerStrategy(&game);
+    }
+    bench_stop(name, iterations);
+}
+
+/**
+ * Function to check that carol credits the D cards of a round, its own
+ * included, to the round's winner. Player 0 leads S.1, carol plays D.5 and
+ * player 2 plays D.3 and wins, so player 2 has won both when it leads next.
+ * @return 1 if carol's scores are right, 0 if not.
+ */
+int check_carol_scores(void) {
+    CarolState *carol = carol_open(3, 1, 2);
+    if (!carol) {
+        return 0;
+    }
+    uint16_t copies[CARD_CODES] = {0};
+    int dPlayed[3] = {0, 0, 0};
+    StrategyView view = {3, 1, 2, 5, card_set_empty(), copies,
+            card_set_empty(), copies, 0, 0, 1, NULL, dPlayed, 0, carol};
+    card_set_add(&view.seen, card_at(0, 1));
+    carol_track_scores(carol, &view);
+
+    // only player 2's D card reaches dPlayed
+    card_set_add(&view.seen, card_at(2, 5));
+    card_set_add(&view.seen, card_at(2, 3));
+    card_set_add(&view.seen, card_at(3, 4));
+    dPlayed[2] = 1;
+    view.handSize = 4;
+    view.leadPlayer = 2;
+    view.leadSuit = suit_index('H');
+    carol_track_scores(carol, &view);
+    int right = carol->nScore[2] == 1 && carol->dScore[2] == 2;
+    carol_close(carol);
+    return right;
+}
+
+/**
+ * Function acting as entry point for the program.
+ * @param argc - number of arguments supplied at command line.
+ * @param argv - array of strings, an optional number of iterations.
+ * @return 0 when done.
+ */
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+    if (iterations < 1) {
+        fprintf(stderr, "Usage: microbench [iterations]\n");
+        return 1;
+    }
+    if (!check_carol_scores()) {
+        fprintf(stderr, "carol does not credit D cards to the round winner\n");
+        return 1;
+    }
+    Deck decks[BENCH_INPUTS];
+    make_deals(decks);
+    printf("%-28s %10s %10s\n", "benchmark", "ns/op", "allocs/op");
+    bench_decode_hand(decks, iterations);
+    bench_decode_played(decks, iterations);
+    bench_process_input(decks, iterations);
+    bench_validate_play(decks, iterations);
+    bench_check_card_in_hand(decks, iterations);
+    bench_deal_card_to_player(decks, iterations, 0);
+    bench_deal_card_to_player(decks, iterations, 1);
+    bench_resolve_trick(decks, iterations);
+    bench_strategy(decks, iterations, "alice_strategy", &alicePlugin);
+    bench_strategy(decks, iterations, "bob_strategy", &bobPlugin);
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "2310bob.h"
+
+/**
+ * Function to handle bob's move as the lead player
+ * @param view what bob can see of the game.
+ * @return the code of the card to play.
+ */
+int bob_lead_move(const StrategyView *view) {
+    // lowest card of the first suit held, searching in this order
+    int suit = card_set_first_suit(view->hand, "DHSC");
+    return card_code(card_at(suit, card_set_lowest(view->hand, suit)));
+}
+
+/**
+ * Function to handle bob's move regarding D cards played.
+ * @param view what bob can see of the game.
+ * @return the code of the card to play.
+ */
+int bob_d_card_move(const StrategyView *view) {
+    // if we have a card in the lead suit
+    if (card_set_suit(view->hand, view->leadSuit) != 0) {
+        // play the highest card in the lead suit
+        return card_code(card_at(view->leadSuit,
+                card_set_highest(view->hand, view->leadSuit)));
+    } else {
+        // lowest card of the first suit held, searching in this order
+        int suit = card_set_first_suit(view->hand, "SCHD");
+        return card_code(card_at(suit, card_set_lowest(view->hand, suit)));
+    }
+}
+
+/**
+ * Function to handle bob's default move.
+ * @param view what bob can see of the game.
+ * @return the code of the card to play.
+ */
+int bob_default_move(const StrategyView *view) {
+    // highest card of the first suit held, searching in this order
+    int suit = card_set_first_suit(view->hand, "SCDH");
+    return card_code(card_at(suit, card_set_highest(view->hand, suit)));
+}
+
+/**
+ * Function to check if there is a player that has won D cards over threshold.
+ * @param view what bob can see of the game.
+ * @return 1 if true, 0 if false.
+ */
+int player_won_over_threshold(const StrategyView *view) {
+    // for all players
+    for (int i = 0; i < view->playerCount; i++) {
+        // if this player has won threshold - 2 D cards.
+        if (view->dPlayed[i] >= (view->threshold - 2)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to see if there have been any D cards played this round.
+ * @param view what bob can see of the game.
+ * @return 1 if true, 0 if false.
+ */
+int d_cards_in_round(const StrategyView *view) {
+    if (view->dPlayedRound > 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Function to handle overarching decision making of bob's activity.
+ * @param view what bob can see of the game.
+ * @return the code of the card to play.
+ */
+int bob_choose(const StrategyView *view) {
+    //lead move
+    if (view->leadPlayer == view->myID) {
+        return bob_lead_move(view);
+    }
+
+    // D card move - if a D card has been played in the round & someone has
+    // won over threshold - 2 D cards
+    if ((player_won_over_threshold(view) == 1) &&
+            (d_cards_in_round(view) == 1)) {
+        return bob_d_card_move(view);
+    }
+
+    //if card in lead suit
+    if (card_set_suit(view->hand, view->leadSuit) != 0) {
+        // find lowest card & play it.
+        return card_code(card_at(view->leadSuit,
+                card_set_lowest(view->hand, view->leadSuit)));
+    }
+
+    //default move
+    return bob_default_move(view);
+}
+
+// bob as a plug-in, built into 2310bob and 2310sim and as bob.so
+const StrategyPlugin bobPlugin = {STRATEGY_ABI_VERSION, "bob", NULL, NULL,
+        bob_choose};
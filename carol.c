@@ -0,0 +1,682 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+#include "2310carol.h"
+#include "dealgen.h"
+#include "timing.h"
+
+/**
+ * Function to read a whole number setting from the environment.
+ * @param name - environment variable holding it.
+ * @param fallback - value when it is not set or not a number.
+ * @param limit - largest value allowed, larger values are reduced to it.
+ * @return the setting.
+ */
+static long read_setting(const char *name, long fallback, long limit) {
+    const char *text = getenv(name);
+    char *end;
+    long value = text ? strtol(text, &end, 10) : -1;
+    if (!text || *text == '\0' || *end != '\0' || value < 0) {
+        value = fallback;
+    }
+    return value < limit ? value : limit;
+}
+
+/*
+ * Search threads and their node arenas, shared by every seat carol plays
+ * from one thread. Those seats move one at a time, so a --mux process needs
+ * one set for all of its tables, not one for each. 2310sim plays games on
+ * several threads at once, and each of them gets a set of its own.
+ */
+static __thread CarolSearch *searchPool;
+static __thread int poolThreads;
+static __thread int poolPlayers; // players each search's rewards has room for.
+static __thread int poolSeats; // seats open on this thread.
+
+/**
+ * Function to release the shared searches once no seat uses them.
+ */
+static void carol_free_searches(void) {
+    for (int t = 0; searchPool && t < poolThreads; t++) {
+        CarolSearch *search = &searchPool[t];
+        arena_free(&search->nodes);
+        free(search->marks);
+        free(search->tried);
+        free(search->rewards);
+    }
+    free(searchPool);
+    searchPool = NULL;
+    poolThreads = 0;
+    poolPlayers = 0;
+}
+
+/**
+ * Function to get the shared searches for a seat's move, making them first
+ * if there are none yet, or too few for the seat.
+ * @param carol - carol's state for the seat.
+ * @return the searches, NULL if they could not be allocated.
+ */
+static CarolSearch *carol_searches(CarolState *carol) {
+    if (carol->threads > poolThreads || carol->playerCount > poolPlayers) {
+        int threads = carol->threads > poolThreads
+                ? carol->threads : poolThreads;
+        int players = carol->playerCount > poolPlayers
+                ? carol->playerCount : poolPlayers;
+        carol_free_searches();
+        searchPool = calloc(threads, sizeof(CarolSearch));
+        if (!searchPool) {
+            return NULL;
+        }
+        poolThreads = threads;
+        poolPlayers = players;
+        for (int t = 0; t < threads; t++) {
+            CarolSearch *search = &searchPool[t];
+            search->marks = calloc(CARD_CODES, sizeof(uint32_t));
+            search->tried = calloc(CARD_CODES, sizeof(uint32_t));
+            search->rewards = calloc(players, sizeof(double));
+            if (!arena_init(&search->nodes, CAROL_ARENA_SIZE)
+                    || !search->marks || !search->tried
+                    || !search->rewards) {
+                carol_free_searches();
+                return NULL;
+            }
+        }
+    }
+    for (int t = 0; t < carol->threads; t++) {
+        searchPool[t].carol = carol;
+    }
+    return searchPool;
+}
+
+/**
+ * Function to set up carol for one seat, reading the search settings.
+ * @param playerCount - number of players.
+ * @param myID - carol's seat.
+ * @param threshold - number of D cards needed for them to count positively.
+ * @return carol's state, NULL if it could not be allocated.
+ */
+void *carol_open(int playerCount, int myID, int threshold) {
+    CarolState *carol = calloc(1, sizeof(CarolState));
+    if (!carol) {
+        return NULL;
+    }
+    poolSeats++;
+    carol->playerCount = playerCount;
+    carol->myID = myID;
+    carol->threshold = threshold;
+    carol->ms = read_setting(CAROL_MS_ENV, CAROL_DEFAULT_MS, INT_MAX);
+    carol->iterations = read_setting(CAROL_ITERATIONS_ENV, 0, LONG_MAX);
+    if (!carol->ms && !carol->iterations) {
+        carol->ms = CAROL_DEFAULT_MS; // a search must end somehow
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    carol->threads = read_setting(CAROL_THREADS_ENV, cores, CAROL_MAX_THREADS);
+    carol->threads = carol->threads > 0 ? carol->threads : 1;
+    const char *seed = getenv(CAROL_SEED_ENV);
+    carol->seed = seed ? strtoull(seed, NULL, 10) : 0;
+    carol->nScore = calloc(playerCount, sizeof(int));
+    carol->dScore = calloc(playerCount, sizeof(int));
+    if (!carol->nScore || !carol->dScore || !carol_searches(carol)) {
+        carol_close(carol);
+        return NULL;
+    }
+    return carol;
+}
+
+/**
+ * Function to release everything carol holds for a seat, and the shared
+ * searches once the last seat on the thread is done.
+ * @param state - what carol_open returned.
+ */
+void carol_close(void *state) {
+    CarolState *carol = state;
+    if (!carol) {
+        return;
+    }
+    if (--poolSeats == 0) {
+        carol_free_searches();
+    }
+    free(carol->nScore);
+    free(carol->dScore);
+    free(carol->root.block);
+    free(carol->unseen);
+    free(carol);
+}
+
+/**
+ * Function to count the D cards played this game before carol's move, from
+ * the cards carol has seen. view->dPlayed cannot be used, as it never counts
+ * carol's own D cards.
+ * @param view - what carol can see of the game.
+ * @return number of D cards played, counting every copy.
+ */
+static int carol_d_seen(const StrategyView *view) {
+    int suit = suit_index('D');
+    int count = 0;
+    for (int rank = 0; rank < CARD_RANKS; rank++) {
+        if (view->seen.suits[suit] >> rank & 1) {
+            count += 1 + view->seenCopies[suit * CARD_RANKS + rank];
+        }
+    }
+    return count;
+}
+
+/**
+ * Function to keep the rounds and D cards each player has won. carol moves
+ * once each round, and whoever leads the round after carol's last move won
+ * it, along with the D cards played between the two moves' rounds,
+ * carol's own included.
+ * @param carol - carol's state for the seat.
+ * @param view - what carol can see of the game.
+ */
+void carol_track_scores(CarolState *carol, const StrategyView *view) {
+    int dBefore = carol_d_seen(view) - view->dPlayedRound;
+    if (!carol->lastHandSize || view->handSize >= carol->lastHandSize) {
+        // a new game
+        memset(carol->nScore, 0, carol->playerCount * sizeof(int));
+        memset(carol->dScore, 0, carol->playerCount * sizeof(int));
+    } else {
+        carol->nScore[view->leadPlayer]++;
+        carol->dScore[view->leadPlayer] += dBefore - carol->lastDBefore;
+    }
+    carol->lastHandSize = view->handSize;
+    carol->lastDBefore = dBefore;
+}
+
+/**
+ * Function to find the bytes a game's arrays take in one block.
+ * @param playerCount - number of players.
+ * @param capacity - most cards each player can hold.
+ * @return bytes needed, a multiple of sizeof(int).
+ */
+size_t carol_game_size(int playerCount, int capacity) {
+    size_t bytes = 3 * playerCount * sizeof(int)
+            + (size_t) playerCount * (capacity + 1);
+    return (bytes + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+/**
+ * Function to lay a game's arrays out in a block of carol_game_size bytes.
+ * @param game - game to set up, its other fields are left alone.
+ * @param playerCount - number of players.
+ * @param capacity - most cards each player can hold.
+ * @param block - storage for the arrays.
+ */
+void carol_game_place(CarolGame *game, int playerCount, int capacity,
+        void *block) {
+    game->playerCount = playerCount;
+    game->capacity = capacity;
+    game->size = carol_game_size(playerCount, capacity);
+    game->block = block;
+    game->counts = block;
+    game->nScore = game->counts + playerCount;
+    game->dScore = game->nScore + playerCount;
+    game->roundCards = (uint8_t *) (game->dScore + playerCount);
+    game->cards = game->roundCards + playerCount;
+}
+
+/**
+ * Function to copy a game into another laid out for the same size.
+ * @param to - game to overwrite.
+ * @param from - game to copy.
+ */
+void carol_game_copy(CarolGame *to, const CarolGame *from) {
+    to->threshold = from->threshold;
+    to->toMove = from->toMove;
+    to->leadPlayer = from->leadPlayer;
+    to->leadSuit = from->leadSuit;
+    to->played = from->played;
+    to->roundsLeft = from->roundsLeft;
+    to->over = from->over;
+    memcpy(to->block, from->block, from->size);
+}
+
+/**
+ * Function to set up the game as carol sees it before a move: carol's hand,
+ * the cards played this round, the scores so far and how many cards each
+ * other player holds. Also lists the cards carol has not seen, which the
+ * other players' hands are dealt from. A standard deck is assumed, with more
+ * copies or ranks whenever more have been seen.
+ * @param carol - carol's state for the seat.
+ * @param view - what carol can see of the game.
+ * @return 1 if the game was set up, 0 if it could not be allocated.
+ */
+int carol_see_game(CarolState *carol, const StrategyView *view) {
+    int players = view->playerCount;
+    size_t size = carol_game_size(players, view->handSize);
+    if (size > carol->rootRoom) {
+        free(carol->root.block);
+        carol->root.block = malloc(size);
+        carol->rootRoom = carol->root.block ? size : 0;
+        if (!carol->root.block) {
+            return 0;
+        }
+    }
+    CarolGame *root = &carol->root;
+    carol_game_place(root, players, view->handSize, root->block);
+    memset(root->block, 0, size);
+    root->threshold = view->threshold;
+    root->toMove = view->myID;
+    root->leadPlayer = view->leadPlayer;
+    root->leadSuit = view->leadSuit;
+    root->played = view->playedCount;
+    root->roundsLeft = view->handSize - 1;
+    root->over = 0;
+    for (int i = 0; i < players; i++) {
+        root->nScore[i] = carol->nScore[i];
+        root->dScore[i] = carol->dScore[i];
+        // those who have played this round hold a card less
+        int order = (i - view->leadPlayer + players) % players;
+        root->counts[i] = view->handSize - (order < view->playedCount);
+    }
+    for (int i = 0; i < view->playedCount; i++) {
+        root->roundCards[(view->leadPlayer + i) % players] = view->played[i];
+    }
+
+    uint8_t *mine = root->cards + view->myID * root->capacity;
+    int held = 0;
+    carol->unseenCount = 0;
+    carol->maxRank = DEALGEN_STANDARD_RANKS;
+    for (int code = 0; code < CARD_CODES; code++) {
+        Card card = wire_to_card(code);
+        int inHand = card_set_has(view->hand, card)
+                ? 1 + view->handCopies[code] : 0;
+        int seen = card_set_has(view->seen, card)
+                ? 1 + view->seenCopies[code] : 0;
+        for (int i = 0; i < inHand && held < root->capacity; i++) {
+            mine[held++] = code;
+        }
+        if (inHand || seen) {
+            int rank = code % CARD_RANKS;
+            carol->maxRank = rank > carol->maxRank ? rank : carol->maxRank;
+        }
+        int standard = card.rank >= 1 && card.rank <= DEALGEN_STANDARD_RANKS;
+        if (standard && !inHand && !seen) {
+            if (carol->unseenCount == carol->unseenSize) {
+                int grown = carol->unseenSize ? carol->unseenSize * 2
+                        : DEALGEN_STANDARD;
+                uint8_t *unseen = realloc(carol->unseen, grown);
+                if (!unseen) {
+                    return 0;
+                }
+                carol->unseen = unseen;
+                carol->unseenSize = grown;
+            }
+            carol->unseen[carol->unseenCount++] = code;
+        }
+    }
+    root->counts[view->myID] = held;
+    return 1;
+}
+
+/**
+ * Function to hash what carol sees before a move, so a search depends on the
+ * position rather than on how many moves the process has made before.
+ * @param view - what carol can see of the game.
+ * @return FNV-1a hash of the seat, cards held and seen and the round so far.
+ */
+uint64_t carol_position(const StrategyView *view) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t words[2 * CARD_SUITS + 3];
+    for (int i = 0; i < CARD_SUITS; i++) {
+        words[i] = view->hand.suits[i];
+        words[CARD_SUITS + i] = view->seen.suits[i];
+    }
+    words[2 * CARD_SUITS] = view->myID;
+    words[2 * CARD_SUITS + 1] = view->leadPlayer;
+    words[2 * CARD_SUITS + 2] = view->handSize;
+    for (size_t i = 0; i < sizeof(words) / sizeof(*words); i++) {
+        hash = (hash ^ words[i]) * 0x100000001b3ULL;
+    }
+    for (int i = 0; i < view->playedCount; i++) {
+        hash = (hash ^ view->played[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Function to take the next random number of a search.
+ * @param search - search drawing the number.
+ * @param limit - numbers are drawn from 0 to limit - 1.
+ * @return the number.
+ */
+static int carol_random(CarolSearch *search, int limit) {
+    return dealgen_random(search->carol->seed, search->stream,
+            search->counter++) % limit;
+}
+
+/**
+ * Function to play a card for the player to move, resolving the round as
+ * engine_resolve_trick does once everyone has played.
+ * @param game - game to play in.
+ * @param code - card to play, which the player to move holds.
+ */
+void carol_game_play(CarolGame *game, uint8_t code) {
+    int mover = game->toMove;
+    uint8_t *hand = game->cards + mover * game->capacity;
+    for (int i = 0; i < game->counts[mover]; i++) {
+        if (hand[i] == code) {
+            hand[i] = hand[--game->counts[mover]];
+            break;
+        }
+    }
+    if (game->played == 0) {
+        game->leadSuit = code / CARD_RANKS;
+    }
+    game->roundCards[mover] = code;
+    game->played++;
+    game->toMove = (mover + 1) % game->playerCount;
+    if (game->played < game->playerCount) {
+        return;
+    }
+
+    // the highest card of the lead suit wins, the last seat of equal ones
+    int rank = 0;
+    int winner = game->leadPlayer;
+    int dCardCount = 0;
+    for (int i = 0; i < game->playerCount; i++) {
+        int suit = game->roundCards[i] / CARD_RANKS;
+        dCardCount += suit == suit_index('D');
+        if (suit == game->leadSuit
+                && game->roundCards[i] % CARD_RANKS >= rank) {
+            rank = game->roundCards[i] % CARD_RANKS;
+            winner = i;
+        }
+    }
+    game->nScore[winner]++;
+    game->dScore[winner] += dCardCount;
+    game->leadPlayer = winner;
+    game->toMove = winner;
+    game->played = 0;
+    game->leadSuit = -1;
+    if (game->roundsLeft == 0) {
+        game->over = 1;
+    } else {
+        game->roundsLeft--;
+    }
+}
+
+/**
+ * Function to start an iteration with the game as carol sees it and the
+ * cards carol has not seen dealt at random to the other players. Cards are
+ * made up when too few are unseen, as when a shoe has copies to come.
+ * @param search - search to deal for.
+ */
+void carol_deal(CarolSearch *search) {
+    CarolState *carol = search->carol;
+    CarolGame *game = &search->game;
+    carol_game_copy(game, &carol->root);
+    // the pool is left in the order of the last deal, as random as any
+    int left = carol->unseenCount;
+    for (int i = 0; i < game->playerCount; i++) {
+        if (i == carol->myID) {
+            continue;
+        }
+        uint8_t *hand = game->cards + i * game->capacity;
+        for (int j = 0; j < game->counts[i]; j++) {
+            if (left > 0) {
+                int pick = carol_random(search, left);
+                hand[j] = search->pool[pick];
+                search->pool[pick] = search->pool[--left];
+                search->pool[left] = hand[j];
+            } else {
+                hand[j] = card_code(card_at(carol_random(search, CARD_SUITS),
+                        1 + carol_random(search, carol->maxRank)));
+            }
+        }
+    }
+}
+
+/**
+ * Function to count the cards of the lead suit the player to move holds.
+ * The hub does not make players follow suit, but alice and bob always do,
+ * so the other players are searched as following suit when they can. carol
+ * searches every card it holds, as playing off suit is allowed and can pay.
+ * @param game - game being searched.
+ * @return number of cards held of the lead suit, 0 when leading.
+ */
+static int carol_following(const CarolGame *game) {
+    const uint8_t *hand = game->cards + game->toMove * game->capacity;
+    int following = 0;
+    for (int i = 0; game->leadSuit >= 0 && i < game->counts[game->toMove];
+            i++) {
+        following += hand[i] / CARD_RANKS == game->leadSuit;
+    }
+    return following;
+}
+
+/**
+ * Function to pick a move for the rest of an iteration after the tree: a
+ * random card of the lead suit if the player to move has one, otherwise any
+ * random card.
+ * @param search - search playing the iteration out.
+ * @return code of the card to play.
+ */
+static uint8_t carol_rollout_move(CarolSearch *search) {
+    CarolGame *game = &search->game;
+    uint8_t *hand = game->cards + game->toMove * game->capacity;
+    int count = game->counts[game->toMove];
+    int following = carol_following(game);
+    if (following == 0) {
+        return hand[carol_random(search, count)];
+    }
+    int pick = carol_random(search, following);
+    for (int i = 0; ; i++) {
+        if (hand[i] / CARD_RANKS == game->leadSuit && pick-- == 0) {
+            return hand[i];
+        }
+    }
+}
+
+/**
+ * Function to score a finished iteration for each player, from 0 for the
+ * lowest final score to 1 for the highest.
+ * @param search - search whose game is over.
+ */
+static void carol_rewards(CarolSearch *search) {
+    CarolGame *game = &search->game;
+    int low = INT_MAX;
+    int high = INT_MIN;
+    for (int i = 0; i < game->playerCount; i++) {
+        int score = game->dScore[i] >= game->threshold
+                ? game->nScore[i] + game->dScore[i]
+                : game->nScore[i] - game->dScore[i];
+        search->rewards[i] = score;
+        low = score < low ? score : low;
+        high = score > high ? score : high;
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        search->rewards[i] = high == low ? 0.5
+                : (search->rewards[i] - low) / (high - low);
+    }
+}
+
+/**
+ * Function to run one iteration of the search: deal the unseen cards, walk
+ * down the tree choosing among the moves the deal allows, the other players
+ * following suit as in the rollouts, add one move the tree does not have
+ * yet, play the deal out at random and add its reward to every move on the
+ * way.
+ * @param search - search to iterate.
+ */
+void carol_iterate(CarolSearch *search) {
+    CarolGame *game = &search->game;
+    carol_deal(search);
+    CarolNode *node = search->root;
+    int expanded = 0;
+    while (!game->over && !expanded) {
+        int mover = game->toMove;
+        uint8_t *hand = game->cards + mover * game->capacity;
+        if (++search->stamp == 0) {
+            memset(search->marks, 0, CARD_CODES * sizeof(uint32_t));
+            memset(search->tried, 0, CARD_CODES * sizeof(uint32_t));
+            search->stamp = 1;
+        }
+        int following = mover == search->carol->myID ? 0
+                : carol_following(game);
+        for (int i = 0; i < game->counts[mover]; i++) {
+            if (!following || hand[i] / CARD_RANKS == game->leadSuit) {
+                search->marks[hand[i]] = search->stamp;
+            }
+        }
+        // every move the deal allows could have been chosen here
+        for (CarolNode *child = node->child; child; child = child->sibling) {
+            search->tried[child->code] = search->stamp;
+            if (search->marks[child->code] == search->stamp) {
+                child->available++;
+            }
+        }
+        CarolNode *next = NULL;
+        for (int i = 0; i < game->counts[mover] && !expanded; i++) {
+            if (search->marks[hand[i]] == search->stamp
+                    && search->tried[hand[i]] != search->stamp) {
+                expanded = 1;
+                next = arena_alloc(&search->nodes, sizeof(CarolNode));
+                if (next) {
+                    memset(next, 0, sizeof(CarolNode));
+                    next->parent = node;
+                    next->sibling = node->child;
+                    node->child = next;
+                    next->mover = mover;
+                    next->code = hand[i];
+                    next->available = 1;
+                }
+            }
+        }
+        if (!expanded) {
+            // upper confidence bound, with availability for the visits
+            double best = -1;
+            for (CarolNode *child = node->child; child;
+                    child = child->sibling) {
+                if (search->marks[child->code] != search->stamp) {
+                    continue;
+                }
+                double value = child->reward / child->visits
+                        + CAROL_EXPLORATION * sqrt(log(child->available)
+                        / child->visits);
+                if (value > best) {
+                    best = value;
+                    next = child;
+                }
+            }
+        }
+        if (!next) {
+            break; // the tree is full, play out from here
+        }
+        carol_game_play(game, next->code);
+        node = next;
+    }
+    while (!game->over) {
+        carol_game_play(game, carol_rollout_move(search));
+    }
+    carol_rewards(search);
+    for (; node->parent; node = node->parent) {
+        node->visits++;
+        node->reward += search->rewards[node->mover];
+    }
+    node->visits++;
+}
+
+/**
+ * Function to grow one thread's tree until the iteration or time limit.
+ * Everything it allocates comes from its arena, which is reset each move.
+ * @param arg - the thread's CarolSearch.
+ * @return NULL.
+ */
+void *carol_search(void *arg) {
+    CarolSearch *search = arg;
+    CarolState *carol = search->carol;
+    const CarolGame *root = &carol->root;
+    arena_reset(&search->nodes);
+    search->root = NULL;
+    search->iterations = 0;
+    void *block = arena_alloc(&search->nodes, root->size);
+    search->pool = arena_alloc(&search->nodes, carol->unseenCount + 1);
+    CarolNode *tree = arena_alloc(&search->nodes, sizeof(CarolNode));
+    if (!block || !search->pool || !tree) {
+        return NULL;
+    }
+    carol_game_place(&search->game, root->playerCount, root->capacity, block);
+    memcpy(search->pool, carol->unseen, carol->unseenCount);
+    memset(tree, 0, sizeof(CarolNode));
+    tree->mover = -1;
+    search->root = tree;
+    while ((!carol->iterations || search->iterations < carol->iterations)
+            && (!carol->deadline || timing_now() < carol->deadline)) {
+        carol_iterate(search);
+        search->iterations++;
+    }
+    return NULL;
+}
+
+/**
+ * Strategy for carol movements: search every thread's tree and play the
+ * card carol's moves were visited most with over all of them.
+ * @param view what carol can see of the game.
+ * @return the code of the card to play, -1 without a state from carol_open.
+ */
+int carol_choose(const StrategyView *view) {
+    CarolState *carol = view->state;
+    if (!carol) {
+        return -1;
+    }
+    carol_track_scores(carol, view);
+    // the lowest card held, played when there is nothing to search
+    int suit = card_set_first_suit(view->hand, "SCDH");
+    int lowest = suit * CARD_RANKS + card_set_lowest(view->hand, suit);
+    if (!carol_see_game(carol, view) || card_set_count(view->hand) == 1) {
+        return lowest;
+    }
+    carol->searches = carol_searches(carol);
+    if (!carol->searches) {
+        return lowest;
+    }
+    carol->position = carol_position(view);
+    const uint8_t *mine = carol->root.cards
+            + view->myID * carol->root.capacity;
+
+    carol->deadline = carol->ms
+            ? timing_now() + (uint64_t) carol->ms * 1000000 : 0;
+    int started[carol->threads];
+    for (int t = 0; t < carol->threads; t++) {
+        CarolSearch *search = &carol->searches[t];
+        // random numbers depend on the seed, position and thread only
+        search->stream = carol->position * CAROL_MAX_THREADS + t;
+        search->counter = 0;
+        started[t] = t > 0
+                && pthread_create(&search->thread, NULL, carol_search,
+                search) == 0;
+    }
+    carol_search(&carol->searches[0]);
+    for (int t = 1; t < carol->threads; t++) {
+        if (started[t]) {
+            pthread_join(carol->searches[t].thread, NULL);
+        } else {
+            carol_search(&carol->searches[t]);
+        }
+    }
+
+    uint64_t visits[CARD_CODES] = {0};
+    for (int t = 0; t < carol->threads; t++) {
+        CarolNode *tree = carol->searches[t].root;
+        for (CarolNode *child = tree ? tree->child : NULL; child;
+                child = child->sibling) {
+            visits[child->code] += child->visits;
+        }
+    }
+    // the most visited card, the lowest code of those visited as often
+    int best = mine[0];
+    for (int i = 1; i < carol->root.counts[view->myID]; i++) {
+        if (visits[mine[i]] > visits[best]
+                || (visits[mine[i]] == visits[best] && mine[i] < best)) {
+            best = mine[i];
+        }
+    }
+    return best;
+}
+
+// carol as a plug-in, built into 2310hub and 2310sim and as carol.so
+const StrategyPlugin carolPlugin = {STRATEGY_ABI_VERSION, "carol", carol_open,
+        carol_close, carol_choose};
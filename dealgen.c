@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "dealgen.h"
+
+/**
+ * Function to scramble a 64 bit number (the splitmix64 finaliser).
+ * @param x - number to scramble.
+ * @return the scrambled number.
+ */
+static uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Function to get a random number from a counter based generator. There is
+ * no state, the same arguments always give the same number.
+ * @param seed - seed of the run.
+ * @param game - game number within the run.
+ * @param counter - which number of the game is wanted.
+ * @return 64 random bits.
+ */
+uint64_t dealgen_random(uint64_t seed, uint64_t game, uint64_t counter) {
+    // each (seed, game) pair gets its own key, the counter steps through it
+    uint64_t key = mix64(mix64(seed) ^ (game * 0x9E3779B97F4A7C15ull));
+    return mix64(key + (counter + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+/**
+ * Function to read a number with nothing but digits.
+ * @param text - text to read.
+ * @param limit - largest number allowed.
+ * @param value - where to store the number.
+ * @return 1 if the text is a number no bigger than limit, 0 if not.
+ */
+static int read_number(const char *text, int limit, int *value) {
+    if (*text == '\0' || strlen(text) > 9) {
+        return 0;
+    }
+    for (const char *c = text; *c; c++) {
+        if (!isdigit(*c)) {
+            return 0;
+        }
+    }
+    *value = atoi(text);
+    return *value <= limit;
+}
+
+/**
+ * Function to read a deck spec: "standard" for the whole standard deck, a
+ * number of cards to deal from it, or "shoe:D" for every card of D standard
+ * decks shuffled together. "shoe:D:R" gives each deck of the shoe ranks 1 to
+ * R in every suit, up to CARD_RANKS - 1.
+ * @param spec - spec given on the command line.
+ * @param deal - where to store what each deal holds.
+ * @return 1 if the spec is valid, 0 if not.
+ */
+int dealgen_spec(const char *spec, DealSpec *deal) {
+    deal->decks = 1;
+    deal->ranks = DEALGEN_STANDARD_RANKS;
+    deal->cards = DEALGEN_STANDARD;
+    if (strcmp(spec, "standard") == 0) {
+        return 1;
+    }
+    if (strncmp(spec, "shoe:", 5) == 0) {
+        char decks[strlen(spec)];
+        strcpy(decks, spec + 5);
+        char *ranks = strchr(decks, ':');
+        if (ranks) {
+            *ranks++ = '\0';
+            if (!read_number(ranks, CARD_RANKS - 1, &deal->ranks)
+                    || deal->ranks < 1) {
+                return 0;
+            }
+        }
+        if (!read_number(decks, DEALGEN_MAX_DECKS, &deal->decks)
+                || deal->decks < 1) {
+            return 0;
+        }
+        deal->cards = dealgen_shoe_size(deal);
+        return 1;
+    }
+    return read_number(spec, DEALGEN_STANDARD, &deal->cards)
+            && deal->cards >= 1;
+}
+
+/**
+ * Function to get the number of cards in the shoe a spec deals from.
+ * @param deal - what each deal holds.
+ * @return the number of cards, the room a deck needs for dealgen_deal.
+ */
+int dealgen_shoe_size(const DealSpec *deal) {
+    return deal->decks * CARD_SUITS * deal->ranks;
+}
+
+/**
+ * Function to deal game k of a seed: a Fisher-Yates shuffle of the shoe, of
+ * which the first cards are kept. The standard deck is a shoe of one deck.
+ * @param seed - seed of the run.
+ * @param game - game number within the run.
+ * @param deal - what each deal holds.
+ * @param deck - deck to fill, with room for dealgen_shoe_size cards.
+ */
+void dealgen_deal(uint64_t seed, uint64_t game, const DealSpec *deal,
+        Deck *deck) {
+    // the shoe is laid out in the deck, one deck after another
+    Card *shuffled = deck->contents;
+    int size = dealgen_shoe_size(deal);
+    for (int i = 0; i < size; i++) {
+        int card = i % (CARD_SUITS * deal->ranks);
+        shuffled[i] = card_at(card / deal->ranks, card % deal->ranks + 1);
+    }
+    // only the positions that are kept need to be drawn
+    for (int i = 0; i < deal->cards; i++) {
+        uint64_t left = size - i;
+        // top 32 bits scaled to the range, the bias is far below 2^-26
+        int j = i + (int) (((dealgen_random(seed, game, i) >> 32) * left)
+                >> 32);
+        Card swap = shuffled[i];
+        shuffled[i] = shuffled[j];
+        shuffled[j] = swap;
+    }
+    deck->count = deal->cards;
+    deck->used = 0;
+}
@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include "shared.h"
+
+#ifndef DEALGEN_H
+#define DEALGEN_H
+
+/*
+ * Seeded deal generation. Every random number is a pure function of the
+ * seed, the game number and a counter, so game k of a seed deals the same
+ * cards whichever thread or machine makes it and whatever came before it.
+ */
+
+// cards in the standard deck, ranks 1 - f in each of S, C, D and H
+#define DEALGEN_STANDARD 60
+
+// ranks in each suit of the standard deck
+#define DEALGEN_STANDARD_RANKS 15
+
+// most decks in a shoe
+#define DEALGEN_MAX_DECKS 256
+
+// spec used when only --seed is given
+#define DEALGEN_DEFAULT_SPEC "standard"
+
+// struct for what a deck spec deals
+typedef struct {
+    int decks; // decks shuffled together into the shoe.
+    int ranks; // each deck has ranks 1 to ranks in every suit.
+    int cards; // cards dealt from the shuffled shoe.
+} DealSpec;
+
+uint64_t dealgen_random(uint64_t seed, uint64_t game, uint64_t counter);
+
+int dealgen_spec(const char *spec, DealSpec *deal);
+
+int dealgen_shoe_size(const DealSpec *deal);
+
+void dealgen_deal(uint64_t seed, uint64_t game, const DealSpec *deal,
+        Deck *deck);
+
+#endif
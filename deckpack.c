@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "deckpack.h"
+
+/**
+ * Function to read a little endian 32 bit number.
+ * @param bytes - the four bytes of the number.
+ * @return the number.
+ */
+static uint32_t read_u32(const unsigned char *bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16
+            | (uint32_t) bytes[3] << 24;
+}
+
+/**
+ * Function to write a little endian 32 bit number.
+ * @param output - file to write to.
+ * @param value - the number.
+ */
+static void write_u32(FILE *output, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF,
+            (value >> 16) & 0xFF, value >> 24};
+    fwrite(bytes, 1, 4, output);
+}
+
+/**
+ * Function to check a pack header and find the deal count.
+ * @param header - the first DECKPACK_HEADER_SIZE bytes of the pack.
+ * @param pack - pack to fill in the deal count of.
+ * @return 1 if the header is valid, 0 if not.
+ */
+static int read_header(const unsigned char *header, DeckPack *pack) {
+    if (memcmp(header, DECKPACK_MAGIC, DECKPACK_MAGIC_SIZE) != 0
+            || read_u32(header + DECKPACK_MAGIC_SIZE) != DECKPACK_VERSION) {
+        return 0;
+    }
+    pack->dealCount = read_u32(header + DECKPACK_MAGIC_SIZE + 4);
+    return 1;
+}
+
+/**
+ * Function to set up reading a pack from a pipe (or any file which cannot be
+ * mapped), reading past the header and index.
+ * @param pack - pack to set up, with stream already open.
+ * @return 1 if the pack is valid so far, 0 if not.
+ */
+static int open_stream(DeckPack *pack) {
+    unsigned char header[DECKPACK_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), pack->stream) != sizeof(header)
+            || !read_header(header, pack)) {
+        return 0;
+    }
+    // deals are read in order, so the index is not needed
+    if (pack->dealCount != DECKPACK_STREAMED) {
+        unsigned char skip[BUFSIZ];
+        size_t left = (size_t) pack->dealCount * 4;
+        while (left > 0) {
+            size_t chunk = left < sizeof(skip) ? left : sizeof(skip);
+            if (fread(skip, 1, chunk, pack->stream) != chunk) {
+                return 0;
+            }
+            left -= chunk;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function to set up reading a pack from a mapped file.
+ * @param pack - pack to set up, with map already set.
+ * @return 1 if the pack is valid so far, 0 if not.
+ */
+static int open_map(DeckPack *pack) {
+    if (pack->mapSize < DECKPACK_HEADER_SIZE
+            || !read_header(pack->map, pack)) {
+        return 0;
+    }
+    pack->deals = pack->map + DECKPACK_HEADER_SIZE;
+    if (pack->dealCount != DECKPACK_STREAMED) {
+        size_t indexSize = (size_t) pack->dealCount * 4;
+        if (indexSize > pack->mapSize - DECKPACK_HEADER_SIZE) {
+            return 0;
+        }
+        pack->index = pack->deals;
+        pack->deals += indexSize;
+    }
+    return 1;
+}
+
+/**
+ * Function to open a deck pack. Regular files are mapped into memory, pipes
+ * and stdin (given as "-") are read as a stream.
+ * @param pack - pack to open.
+ * @param name - file name of the pack, or "-" for stdin.
+ * @return 1 if the pack was opened, 0 if it is missing or invalid.
+ */
+int deckpack_open(DeckPack *pack, const char *name) {
+    memset(pack, 0, sizeof(DeckPack));
+    int fd = strcmp(name, "-") == 0 ? STDIN_FILENO : open(name, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            // the mapping stays valid once the file is closed
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            if (fd != STDIN_FILENO) {
+                close(fd);
+            }
+            pack->map = map;
+            pack->mapSize = info.st_size;
+            return open_map(pack);
+        }
+    }
+    pack->stream = fd == STDIN_FILENO ? stdin : fdopen(fd, "r");
+    return pack->stream != NULL && open_stream(pack);
+}
+
+/**
+ * Function to read the next deal of a pack into a deck. Each deal is checked
+ * as it is read, so a bad deal late in a pack does not stop earlier games.
+ * @param pack - pack to read from.
+ * @param deck - deck to fill, with room for DECKPACK_MAX_CARDS cards.
+ * @return 1 if a deal was read
+ *         0 if there are no more deals
+ *         -1 if the deal is invalid.
+ */
+int deckpack_next(DeckPack *pack, Deck *deck) {
+    unsigned char bytes[DECKPACK_MAX_CARDS];
+    const unsigned char *cards = bytes;
+    size_t count;
+    if (pack->dealCount != DECKPACK_STREAMED
+            && pack->next == pack->dealCount) {
+        return 0;
+    }
+    if (pack->map) {
+        // the mapped bytes are read in place, with no intermediate buffer,
+        // and converted into the deck below
+        size_t available = pack->mapSize - (pack->deals - pack->map);
+        size_t offset = pack->index
+                ? read_u32(pack->index + (size_t) pack->next * 4)
+                : pack->offset;
+        if (!pack->index && offset == available) {
+            return 0;
+        }
+        if (offset > available || available - offset < 2) {
+            return -1;
+        }
+        count = pack->deals[offset] | pack->deals[offset + 1] << 8;
+        if (count > available - offset - 2) {
+            return -1;
+        }
+        cards = pack->deals + offset + 2;
+        pack->offset = offset + 2 + count;
+    } else {
+        int first = getc(pack->stream);
+        if (first == EOF) {
+            return pack->dealCount == DECKPACK_STREAMED ? 0 : -1;
+        }
+        int second = getc(pack->stream);
+        count = first | second << 8;
+        if (second == EOF || fread(bytes, 1, count, pack->stream) != count) {
+            return -1;
+        }
+    }
+
+    // every byte is a card, and a shoe may hold several copies of one
+    for (size_t i = 0; i < count; i++) {
+        deck->contents[i] = wire_to_card(cards[i]);
+    }
+    deck->count = count;
+    deck->used = 0;
+    pack->next++;
+    return 1;
+}
+
+/**
+ * Function to release a pack opened with deckpack_open.
+ * @param pack - pack to close.
+ */
+void deckpack_close(DeckPack *pack) {
+    if (pack->map) {
+        munmap((void *) pack->map, pack->mapSize);
+    } else if (pack->stream && pack->stream != stdin) {
+        fclose(pack->stream);
+    }
+    pack->map = NULL;
+    pack->stream = NULL;
+}
+
+/**
+ * Function to write the header of a pack.
+ * @param output - file to write to.
+ * @param dealCount - number of deals, DECKPACK_STREAMED if not known.
+ */
+void deckpack_write_header(FILE *output, uint32_t dealCount) {
+    fwrite(DECKPACK_MAGIC, 1, DECKPACK_MAGIC_SIZE, output);
+    write_u32(output, DECKPACK_VERSION);
+    write_u32(output, dealCount);
+}
+
+/**
+ * Function to write the index of a pack, which must follow the header.
+ * @param output - file to write to.
+ * @param decks - every deal the pack will hold, in order.
+ * @param count - number of deals.
+ */
+void deckpack_write_index(FILE *output, const Deck *decks, uint32_t count) {
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        write_u32(output, offset);
+        offset += 2 + decks[i].count;
+    }
+}
+
+/**
+ * Function to write a deal to a pack.
+ * @param output - file to write to.
+ * @param deck - deal to write, of at most DECKPACK_MAX_CARDS cards.
+ */
+void deckpack_write_deal(FILE *output, const Deck *deck) {
+    putc(deck->count & 0xFF, output);
+    putc(deck->count >> 8, output);
+    for (unsigned int i = 0; i < deck->count; i++) {
+        putc(card_to_wire(deck->contents[i]), output);
+    }
+}
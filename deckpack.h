@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "shared.h"
+
+#ifndef DECKPACK_H
+#define DECKPACK_H
+
+/*
+ * Deck pack: many deals in one file, one byte per card (see card_to_wire).
+ *   header  "2310PACK" [version u32][deal count u32]
+ *   index   [deal count x u32 offset of each deal from the end of the index]
+ *   deals   [card count u16][card count card bytes] ...
+ * Numbers are little endian. A pack written by a generator that does not
+ * know how many deals it will produce uses DECKPACK_STREAMED as the deal
+ * count, has no index and ends at end of file.
+ */
+#define DECKPACK_MAGIC "2310PACK"
+#define DECKPACK_MAGIC_SIZE 8
+#define DECKPACK_VERSION 2
+#define DECKPACK_HEADER_SIZE 16
+#define DECKPACK_STREAMED 0xFFFFFFFFu
+
+// most cards a deal can hold, a shoe may hold several copies of a card
+#define DECKPACK_MAX_CARDS 0xFFFF
+
+// struct for a deck pack being read
+typedef struct {
+    const unsigned char *map; // whole file when it could be mapped
+    size_t mapSize;
+    FILE *stream; // used instead of map for pipes and stdin
+    uint32_t dealCount; // DECKPACK_STREAMED if not known
+    const unsigned char *index; // into map, NULL when streaming
+    const unsigned char *deals; // into map, start of the first deal
+    size_t offset; // from deals, of the deal after the last one read
+    uint32_t next; // deal to read next
+} DeckPack;
+
+int deckpack_open(DeckPack *pack, const char *name);
+
+int deckpack_next(DeckPack *pack, Deck *deck);
+
+void deckpack_close(DeckPack *pack);
+
+void deckpack_write_header(FILE *output, uint32_t dealCount);
+
+void deckpack_write_index(FILE *output, const Deck *decks, uint32_t count);
+
+void deckpack_write_deal(FILE *output, const Deck *deck);
+
+#endif
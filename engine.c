@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include "engine.h"
+
+/**
+ * Function to set up an engine for games between a fixed set of players.
+ * Storage for rounds is allocated by engine_deal once the hand size is known.
+ * @param game struct representing the engine's state of the game.
+ * @param playerCount - number of players.
+ * @param threshold - number of D cards needed for them to count positively.
+ */
+void engine_init(EngineGame *game, int playerCount, int threshold) {
+    memset(game, 0, sizeof(EngineGame));
+    game->playerCount = playerCount;
+    game->threshold = threshold;
+    game->hands = calloc(playerCount, sizeof(CardHand));
+    game->nScore = calloc(playerCount, sizeof(int));
+    game->dScore = calloc(playerCount, sizeof(int));
+    game->finalScores = calloc(playerCount, sizeof(int));
+}
+
+/**
+ * Function to release the storage held by an engine.
+ * @param game struct representing the engine's state of the game.
+ */
+void engine_free(EngineGame *game) {
+    free(game->hands);
+    free(game->cardsByRound);
+    free(game->cardsOrderPlayed);
+    free(game->leadByRound);
+    free(game->nScore);
+    free(game->dScore);
+    free(game->finalScores);
+}
+
+/**
+ * Function to start a new game, dealing handSize cards to each player in turn
+ * from the front of the deck. Storage is reused between games and only grows.
+ * @param game struct representing the engine's state of the game.
+ * @param deck - cards to deal, at least handSize * playerCount of them.
+ * @param handSize - number of cards for each player.
+ */
+void engine_deal(EngineGame *game, const Card *deck, int handSize) {
+    if (handSize > game->roundCapacity) {
+        int cells = handSize * game->playerCount;
+        game->cardsByRound = realloc(game->cardsByRound, cells * sizeof(Card));
+        game->cardsOrderPlayed = realloc(game->cardsOrderPlayed,
+                cells * sizeof(Card));
+        game->leadByRound = realloc(game->leadByRound, handSize * sizeof(int));
+        game->roundCapacity = handSize;
+    }
+    game->handSize = handSize;
+    for (int i = 0; i < game->playerCount; i++) {
+        hand_clear(&game->hands[i]);
+        for (int j = 0; j < handSize; j++) {
+            hand_add(&game->hands[i], deck[i * handSize + j]);
+        }
+        game->nScore[i] = 0;
+        game->dScore[i] = 0;
+        game->finalScores[i] = 0;
+    }
+    game->leadPlayer = 0;
+    game->toMove = 0;
+    game->played = 0;
+    game->roundNumber = 0;
+    game->leadByRound[0] = 0;
+}
+
+/**
+ * Function to check if a player holds a card.
+ * @param game struct representing the engine's state of the game.
+ * @param player - player to check.
+ * @param card - card to look for.
+ * @return 1 if held, 0 if not.
+ */
+int engine_holds(const EngineGame *game, int player, Card card) {
+    return hand_has(&game->hands[player], card);
+}
+
+/**
+ * Function to play a card for a player, advancing the game by one step.
+ * Completing a trick resolves it (the winner leads next) and completing the
+ * last trick calculates the final scores.
+ * @param game struct representing the engine's state of the game.
+ * @param player - player making the move.
+ * @param card - card they play.
+ * @return ENGINE_OK, ENGINE_TRICK or ENGINE_GAMEOVER if the card was played,
+ *         ENGINE_NOT_TURN, ENGINE_NOT_HELD or ENGINE_FINISHED if not.
+ */
+EngineStatus engine_play(EngineGame *game, int player, Card card) {
+    if (game->roundNumber == game->handSize) {
+        return ENGINE_FINISHED;
+    }
+    if (player != game->toMove) {
+        return ENGINE_NOT_TURN;
+    }
+    if (!engine_holds(game, player, card)) {
+        return ENGINE_NOT_HELD;
+    }
+    hand_remove(&game->hands[player], card);
+    if (player == game->leadPlayer) {
+        game->leadSuit = card.suit;
+    }
+    int round = game->roundNumber * game->playerCount;
+    game->cardsByRound[round + player] = card;
+    game->cardsOrderPlayed[round + game->played] = card;
+    game->played++;
+    game->toMove = (player + 1) % game->playerCount;
+    if (game->played < game->playerCount) {
+        return ENGINE_OK;
+    }
+
+    // everyone has played, the winner of the trick leads the next one
+    engine_resolve_trick(game);
+    game->played = 0;
+    game->toMove = game->leadPlayer;
+    game->roundNumber++;
+    if (game->roundNumber == game->handSize) {
+        engine_final_scores(game);
+        return ENGINE_GAMEOVER;
+    }
+    game->leadByRound[game->roundNumber] = game->leadPlayer;
+    return ENGINE_TRICK;
+}
+
+/**
+ * Function to find the winner of the current round (highest card in the lead
+ * suit) and give them the round and any D cards played.
+ * @param game struct representing the engine's state of the game.
+ */
+void engine_resolve_trick(EngineGame *game) {
+    int rank = 0;
+    int winner = -1;
+    int dCardCount = 0;
+    Card *cards = game->cardsByRound + game->roundNumber * game->playerCount;
+    // calculate number of D cards played
+    for (int i = 0; i < game->playerCount; i++) {
+        if (cards[i].suit == 'D') {
+            dCardCount++;
+        }
+        // find the winner of the round based on highest
+        if (game->leadSuit == cards[i].suit) {
+            if (cards[i].rank >= rank) {
+                rank = cards[i].rank;
+                winner = i;
+            }
+        }
+    }
+    // allocate score to the winner
+    game->leadPlayer = winner;
+    game->nScore[winner] += 1;
+    game->dScore[winner] += dCardCount;
+}
+
+/**
+ * Function to calculate the final scores based on whether each player reached
+ * the D card threshold.
+ * @param game struct representing the engine's state of the game.
+ */
+void engine_final_scores(EngineGame *game) {
+    for (int i = 0; i < game->playerCount; i++) {
+        if (game->dScore[i] >= game->threshold) {
+            game->finalScores[i] = game->nScore[i] + game->dScore[i];
+        } else {
+            game->finalScores[i] = game->nScore[i] - game->dScore[i];
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#include "shared.h"
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+/*
+ * Rules engine for the card game. It holds the full state of one game and
+ * performs dealing, play validation, trick resolution and final scoring with
+ * no I/O, so the hub and in-process simulations share the same rules.
+ */
+
+/* enum for the result of a step of the engine */
+typedef enum {
+    ENGINE_OK = 0, // card played, the trick continues
+    ENGINE_TRICK = 1, // card played and the trick is complete
+    ENGINE_GAMEOVER = 2, // card played and the last trick is complete
+    ENGINE_NOT_TURN = 3, // it is not this player's turn
+    ENGINE_NOT_HELD = 4, // the player does not hold this card
+    ENGINE_FINISHED = 5 // the game is already over
+} EngineStatus;
+
+// struct for the engine's state of a game
+typedef struct {
+    int playerCount;
+    int threshold;
+    int handSize; // cards dealt to each player, also the number of rounds
+    int roundCapacity; // rounds the per round arrays have room for
+
+    CardHand *hands; // cards still held by each player
+    int leadPlayer; // lead of the current round, winner once it is done
+    char leadSuit;
+    int toMove; // player whose turn it is
+    int played; // cards played in the current round
+    int roundNumber; // 0 based, equal to handSize once the game is over
+
+    Card *cardsByRound; // [round * playerCount + player]
+    Card *cardsOrderPlayed; // [round * playerCount + order played]
+    int *leadByRound; // lead player of each round
+    int *nScore; // rounds won by each player
+    int *dScore; // D cards won by each player
+    int *finalScores;
+} EngineGame;
+
+void engine_init(EngineGame *game, int playerCount, int threshold);
+
+void engine_free(EngineGame *game);
+
+void engine_deal(EngineGame *game, const Card *deck, int handSize);
+
+int engine_holds(const EngineGame *game, int player, Card card);
+
+EngineStatus engine_play(EngineGame *game, int player, Card card);
+
+void engine_resolve_trick(EngineGame *game);
+
+void engine_final_scores(EngineGame *game);
+
+#endif
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gamelog.h"
+
+/**
+ * Function to write a little endian 32 bit number.
+ * @param output - file to write to.
+ * @param value - the number.
+ */
+static void write_u32(FILE *output, uint32_t value) {
+    unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF,
+            (value >> 16) & 0xFF, value >> 24};
+    fwrite(bytes, 1, 4, output);
+}
+
+/**
+ * Function to write a little endian 16 bit number.
+ * @param output - file to write to.
+ * @param value - the number.
+ */
+static void write_u16(FILE *output, uint16_t value) {
+    putc(value & 0xFF, output);
+    putc(value >> 8, output);
+}
+
+/**
+ * Function to read a little endian 16 bit number.
+ * @param bytes - the two bytes of the number.
+ * @return the number.
+ */
+static uint16_t read_u16(const unsigned char *bytes) {
+    return bytes[0] | bytes[1] << 8;
+}
+
+/**
+ * Function to write the header of a log, only when starting a new file.
+ * @param output - file to write to.
+ */
+void gamelog_write_header(FILE *output) {
+    fwrite(GAMELOG_MAGIC, 1, GAMELOG_MAGIC_SIZE, output);
+    write_u32(output, GAMELOG_VERSION);
+}
+
+/**
+ * Function to append a finished game to a log.
+ * @param output - file to write to.
+ * @param number - game number of the game.
+ * @param game - engine holding the finished game.
+ * @param deal - cards the game was dealt from, in the order dealt.
+ */
+void gamelog_write_game(FILE *output, uint32_t number,
+        const EngineGame *game, const Card *deal) {
+    int cells = game->playerCount * game->handSize;
+    write_u32(output, number);
+    write_u16(output, game->playerCount);
+    write_u16(output, game->handSize);
+    write_u16(output, game->threshold < 0xFFFF ? game->threshold : 0xFFFF);
+    write_u16(output, 0);
+    for (int i = 0; i < cells; i++) {
+        putc(card_to_wire(deal[i]), output);
+    }
+    for (int r = 0; r < game->handSize; r++) {
+        write_u16(output, game->leadByRound[r]);
+    }
+    for (int i = 0; i < cells; i++) {
+        putc(card_to_wire(game->cardsOrderPlayed[i]), output);
+    }
+    for (int i = 0; i < game->playerCount; i++) {
+        write_u32(output, game->finalScores[i]);
+    }
+}
+
+/**
+ * Function to open a log by mapping it into memory.
+ * @param log - log to open.
+ * @param name - file name of the log.
+ * @return 1 if the log was opened, 0 if it is missing or has a bad header.
+ */
+int gamelog_open(GameLog *log, const char *name) {
+    memset(log, 0, sizeof(GameLog));
+    int fd = open(name, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < GAMELOG_HEADER_SIZE) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+    madvise(map, info.st_size, MADV_SEQUENTIAL);
+    log->map = map;
+    log->mapSize = info.st_size;
+    log->offset = GAMELOG_HEADER_SIZE;
+    const unsigned char *version = log->map + GAMELOG_MAGIC_SIZE;
+    return memcmp(log->map, GAMELOG_MAGIC, GAMELOG_MAGIC_SIZE) == 0
+            && (version[0] | version[1] << 8 | version[2] << 16
+            | (uint32_t) version[3] << 24) == GAMELOG_VERSION;
+}
+
+/**
+ * Function to find the next game of a log. Nothing is copied, the record
+ * points into the mapping.
+ * @param log - log to read from.
+ * @param record - record to fill in.
+ * @return 1 if a game was found
+ *         0 if there are no more games
+ *         -1 if the log is cut short or a game's header is invalid.
+ */
+int gamelog_next(GameLog *log, GameRecord *record) {
+    size_t available = log->mapSize - log->offset;
+    if (available == 0) {
+        return 0;
+    } else if (available < GAMELOG_GAME_HEADER_SIZE) {
+        return -1;
+    }
+    const unsigned char *game = log->map + log->offset;
+    record->number = game[0] | game[1] << 8 | game[2] << 16
+            | (uint32_t) game[3] << 24;
+    record->playerCount = read_u16(game + 4);
+    record->handSize = read_u16(game + 6);
+    record->threshold = read_u16(game + 8);
+    size_t cells = (size_t) record->playerCount * record->handSize;
+    size_t size = GAMELOG_GAME_HEADER_SIZE + 2 * cells
+            + 2 * record->handSize + 4 * record->playerCount;
+    if (record->playerCount < 2 || record->handSize < 1 || size > available) {
+        return -1;
+    }
+    record->deal = game + GAMELOG_GAME_HEADER_SIZE;
+    record->leads = record->deal + cells;
+    record->order = record->leads + 2 * record->handSize;
+    record->scores = record->order + cells;
+    log->offset += size;
+    return 1;
+}
+
+/**
+ * Function to get the player who led a round of a recorded game.
+ * @param record - game to look in.
+ * @param round - 0 based round.
+ * @return the lead player.
+ */
+int gamelog_lead(const GameRecord *record, int round) {
+    return read_u16(record->leads + 2 * round);
+}
+
+/**
+ * Function to get a player's recorded final score.
+ * @param record - game to look in.
+ * @param player - player whose score to get.
+ * @return the score.
+ */
+int gamelog_score(const GameRecord *record, int player) {
+    const unsigned char *score = record->scores + 4 * player;
+    return (int32_t) (score[0] | score[1] << 8 | score[2] << 16
+            | (uint32_t) score[3] << 24);
+}
+
+/**
+ * Function to release a log opened with gamelog_open.
+ * @param log - log to close.
+ */
+void gamelog_close(GameLog *log) {
+    if (log->map) {
+        munmap((void *) log->map, log->mapSize);
+    }
+    log->map = NULL;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "shared.h"
+#include "engine.h"
+
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+/*
+ * Game log: a record of every finished game, one byte per card (see
+ * card_to_wire), appended by the hub's --log option.
+ *   header  "2310GLOG" [version u32]
+ *   games   [game number u32][players u16][hand size u16][threshold u16]
+ *           [0 u16]
+ *           [deal, players x hand size cards, player 0's hand first]
+ *           [lead player of each round, hand size x u16]
+ *           [cards in the order played, players x hand size cards]
+ *           [final score of each player, players x i32]
+ * Numbers are little endian. Every game of the same size has a record of the
+ * same size. Thresholds are stored up to 65535, which no deal can reach.
+ */
+#define GAMELOG_MAGIC "2310GLOG"
+#define GAMELOG_MAGIC_SIZE 8
+#define GAMELOG_VERSION 2
+#define GAMELOG_HEADER_SIZE 12
+#define GAMELOG_GAME_HEADER_SIZE 12
+
+// struct for one game of a log, pointing into the mapped log
+typedef struct {
+    uint32_t number;
+    int playerCount;
+    int handSize;
+    int threshold;
+    const unsigned char *deal;
+    const unsigned char *leads; // u16 each, see gamelog_lead.
+    const unsigned char *order;
+    const unsigned char *scores;
+} GameRecord;
+
+// struct for a game log being read
+typedef struct {
+    const unsigned char *map;
+    size_t mapSize;
+    size_t offset; // of the game after the last one read
+} GameLog;
+
+void gamelog_write_header(FILE *output);
+
+void gamelog_write_game(FILE *output, uint32_t number,
+        const EngineGame *game, const Card *deal);
+
+int gamelog_open(GameLog *log, const char *name);
+
+int gamelog_next(GameLog *log, GameRecord *record);
+
+int gamelog_lead(const GameRecord *record, int round);
+
+int gamelog_score(const GameRecord *record, int player);
+
+void gamelog_close(GameLog *log);
+
+#endif
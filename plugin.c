@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "plugin.h"
+
+/**
+ * Function to check if a player or strategy name is a plug-in.
+ * @param name - name given on the command line.
+ * @return 1 if it names a shared object (ends in ".so"), 0 if not.
+ */
+int is_plugin(const char *name) {
+    size_t length = strlen(name);
+    return length > 3 && strcmp(name + length - 3, ".so") == 0;
+}
+
+/**
+ * Function to load a strategy plug-in. A path without a '/' is taken to be
+ * in the current directory, as for a player program, rather than searched
+ * for like a library.
+ * @param path - file name of the plug-in.
+ * @return the plug-in, NULL if it could not be loaded, does not export
+ *         STRATEGY_ENTRY or was built for another STRATEGY_ABI_VERSION.
+ */
+const StrategyPlugin *plugin_load(const char *path) {
+    char local[strlen(path) + 3];
+    if (!strchr(path, '/')) {
+        sprintf(local, "./%s", path);
+        path = local;
+    }
+    void *library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        return NULL;
+    }
+    StrategyEntry entry;
+    // dlsym returns an object pointer, copied to get the function pointer
+    void *symbol = dlsym(library, STRATEGY_ENTRY);
+    memcpy(&entry, &symbol, sizeof(entry));
+    const StrategyPlugin *plugin = symbol ? entry() : NULL;
+    if (!plugin || plugin->abiVersion != STRATEGY_ABI_VERSION
+            || !plugin->choose) {
+        dlclose(library);
+        return NULL;
+    }
+    return plugin; // stays loaded until the program exits
+}
@@ -0,0 +1,10 @@
+#include "strategy_abi.h"
+
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+int is_plugin(const char *name);
+
+const StrategyPlugin *plugin_load(const char *path);
+
+#endif
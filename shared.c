@@ -10,8 +10,7 @@
 #include "shared.h"
 #include <ctype.h>
 #include <math.h>
-
-#define LINESIZE 80
+#include <limits.h>
 
 /**
  * Function to check if char supplied matches a suit.
@@ -56,21 +55,7 @@ int next_player(PlayerGame *game) {
  * @param game struct representing card to remove.
  */
 void remove_card(PlayerGame *game, Card *card) {
-    int pos = 0;
-    // find position of card to remove
-    for (int i = 0; i < game->handSize; i++) {
-        if (game->hand[i].suit == card->suit) {
-            if (game->hand[i].rank == card->rank) {
-                pos = i;
-                break;
-            }
-        }
-    }
-
-    for (int q = pos; q < game->handSize - 1; q++) {
-        // shift all cards to compensate for removal.
-        game->hand[q] = game->hand[q + 1];
-    }
+    hand_remove(&game->hand, *card);
     game->handSize -= 1;
 }
 
@@ -80,65 +65,9 @@ void remove_card(PlayerGame *game, Card *card) {
  * @param card struct representing card to save
  */
 void save_card(PlayerGame *game, Card *card) {
-    // store the card as a string for endgame output
-    game->cardsStored[game->cardPos][0] = card->suit;
-    game->cardsStored[game->cardPos][1] = '.';
-    game->cardsStored[game->cardPos][2] = card->rank;
-    game->cardsStored[game->cardPos][3] = '\0';
-}
-
-/**
- * Function to see if there is a card in the lead suit.
- * @param game struct representing player's tracking of game.
- * @return 0 - if present
- *         -1 - if not present
- */
-int card_in_lead_suit(PlayerGame *game) {
-    // search all cards for matching suit of players hand.
-    for (int i = 0; i < game->handSize; i++) {
-        if (game->leadSuit == game->hand[i].suit) {
-            return DONE;
-        }
-    }
-    return -1;
-}
-
-/**
- * Function to return the lowest card for a given suit
- * @param game struct representing player's tracking of game.
- * @param suit char representing suit we want
- * @return play - the lowest card
- */
-Card lowest_in_suit(PlayerGame *game, char suit) {
-    int rank = 17; // higher than highest possible rank.
-    Card play;
-    play.rank = -1;
-    // find matching card
-    for (int i = 0; i < game->handSize; i++) {
-        if (suit == game->hand[i].suit) {
-            if (get_rank_integer(game->hand[i].rank) < rank) {
-                // set new lowest
-                rank = get_rank_integer(game->hand[i].rank);
-                play = game->hand[i];
-            }
-        }
-    }
-    return play;
-}
-
-/**
- * Function to get the integer rank of a card from its char rank.
- * @param arg - char to convert
- * @return int representing char.
- */
-int get_rank_integer(char arg) {
-    if (isdigit(arg) != 0) {
-        // 1-9
-        return arg - '0';
-    } else {
-        // HEX
-        return arg - 86;
-    }
+    // store the card for the end of round output and the strategy
+    game->roundCards[game->cardPos] = *card;
+    hand_add(&game->seen, *card);
 }
 
 /**
@@ -154,13 +83,15 @@ PlayerStatus show_player_message(PlayerStatus s) {
             "Invalid threshold\n",
             "Invalid hand size\n",
             "Invalid message\n",
-            "EOF\n"};
+            "EOF\n",
+            "Invalid strategy\n"};
     fputs(messages[s], stderr);
     return s;
 }
 
 /**
- * Function to decode the hand message from stdin.
+ * Function to decode the hand message from stdin, in one pass over the line
+ * however many cards it holds.
  * @param input - string representing message
  * @param game struct representing player's tracking of game.
  * @return 0 - successfully decoded
@@ -169,51 +100,32 @@ PlayerStatus show_player_message(PlayerStatus s) {
  */
 int decode_hand(char *input, PlayerGame *game) {
     input += 4;
-    char *oldInput = malloc(sizeof(char) * strlen(input));
-    strcpy(oldInput, input);
-    input[strlen(input) - 1] = '\0'; // remove extra new line char.
-    char delim[] = ",";
-    char *arrow = strtok(input, delim);
-    int i = 0;
-    // split string on ','
-    while (arrow != NULL) {
-        if (i == 0) {
-            // parse hand size.
-            for (int j = 0; j < strlen(arrow); j++) {
-                if (!isdigit(arrow[j])) {
-                    return show_player_message(HANDERR);
-                }
-            }
-            int tempHandSize;
-            sscanf(arrow, "%d", &tempHandSize);
-            if (tempHandSize != game->handSize) {
-                return show_player_message(MSGERR);
-            }
-        } else if (i > 0) {
-            // parse a card
-            if (strlen(arrow) > 2) {
-                return show_player_message(MSGERR);
-            } else if (validate_card(arrow[0]) && (isdigit(arrow[1])
-                    || isxdigit(arrow[1]))) {
-                Card card;
-                card.suit = arrow[0];
-                card.rank = arrow[1];
-                game->hand[i - 1] = card;
-            } else {
-                return show_player_message(MSGERR);
-            }
-
-        }
-        arrow = strtok(NULL, delim);
-        i++;
+    // parse hand size, which must be the size we were started with
+    int digits = 0;
+    while (isdigit(input[digits])) {
+        digits++;
     }
-    // if card count not equal to hand size, throw
-    if (i - 1 != game->handSize) {
+    if (digits == 0 || (input[digits] != ',' && input[digits] != '\n')) {
+        return show_player_message(HANDERR);
+    }
+    if (digits != number_digits(game->handSize)
+            || atoi(input) != game->handSize) {
         return show_player_message(MSGERR);
     }
+    // parse each card, a shoe may deal several copies of one
+    char *next = input + digits;
+    hand_clear(&game->hand);
+    for (int i = 0; i < game->handSize; i++) {
+        Card card;
+        int length = *next == ',' ? text_to_card(next + 1, &card) : 0;
+        if (length == 0) {
+            return show_player_message(MSGERR);
+        }
+        hand_add(&game->hand, card);
+        next += length + 1;
+    }
     // check msg not extra long
-    if (strlen(oldInput) != number_digits(game->handSize)
-            + 3 * game->handSize + 1) {
+    if (strcmp(next, "\n") != 0) {
         return show_player_message(MSGERR);
     }
     return DONE;
@@ -227,15 +139,14 @@ int decode_hand(char *input, PlayerGame *game) {
  *         6 - error in message
  */
 int decode_newround(char *input, PlayerGame *game) {
-    // set required variables if newround successful.
-    game->orderPos = 0;
-    game->cardPos = 0;
-    game->dPlayedRound = 0;
     input += 8;
     input[strlen(input) - 1] = '\0';
     // get lead player
-    char *leadPlayer = malloc(strlen(input) * sizeof(char));
-    strncpy(leadPlayer, input, strlen(input));
+    char *leadPlayer = arena_alloc(&game->scratch, strlen(input) + 1);
+    if (leadPlayer == NULL) {
+        return show_player_message(MSGERR);
+    }
+    strcpy(leadPlayer, input);
     int i;
     for (i = 0; i < strlen(leadPlayer); i++) {
         if (!isdigit(leadPlayer[i])) {
@@ -246,7 +157,22 @@ int decode_newround(char *input, PlayerGame *game) {
     if (i == 0) {
         return show_player_message(MSGERR);
     }
-    game->leadPlayer = atoi(leadPlayer);
+    return apply_newround(game, atoi(leadPlayer));
+}
+
+/**
+ * Function to start a new round once its message has been decoded.
+ * @param game struct representing player's tracking of game.
+ * @param leadPlayer - player leading the round.
+ * @return 0 - round started
+ *         6 - error in message
+ */
+int apply_newround(PlayerGame *game, int leadPlayer) {
+    // set required variables if newround successful.
+    game->orderPos = 0;
+    game->cardPos = 0;
+    game->dPlayedRound = 0;
+    game->leadPlayer = leadPlayer;
     // make sure first round means player 0 first.
     if (game->firstRound) {
         game->firstRound = 0;
@@ -260,9 +186,8 @@ int decode_newround(char *input, PlayerGame *game) {
     // if we are player to move, perform move!
     if (game->myID == game->leadPlayer) {
         game->playerStrategy(game);
-        if (game->myID == game->playerCount - 1) {
-            game->orderPos = game->myID;
-        }
+        // the turn passes on from us, wherever we sit
+        set_player(game, game->myID);
         next_player(game);
     } else {
         // otherwise there is a non 0 player to move first.
@@ -277,36 +202,22 @@ int decode_newround(char *input, PlayerGame *game) {
     return DONE;
 }
 
-/**
- * Function to decide who was the winner of the round.
- * @param game struct representing player's tracking of game.
- */
-void decide_round_winner(PlayerGame *game) {
-    int rank = 0;
-    // loop through all players and determine highest card played
-    for (int i = 0; i < game->playerCount; i++) {
-        if (game->cardsStored[i][0] == game->leadSuit) {
-            if (get_rank_integer(game->cardsStored[i][2]) > rank) {
-                game->roundWinner = i;
-                rank = get_rank_integer(game->cardsStored[i][0]);
-            }
-        }
-    }
-}
-
 /**
  * Function to output end of round msg to stderr at the end of the round.
  * @param game struct representing player's tracking of game.
  */
 void player_end_of_round_output(PlayerGame *game) {
-    decide_round_winner(game);
+    game->dPlayedRound = 0;
+    if (game->simulated) {
+        return;
+    }
     // print out who is lead and all cards played that round
     fprintf(stderr, "Lead player=%d:", game->leadPlayer);
     for (int i = 0; i < game->cardPos; i++) {
-        fprintf(stderr, " %s", game->cardsStored[i]);
+        fprintf(stderr, " %c.%x", game->roundCards[i].suit,
+                game->roundCards[i].rank);
     }
     fprintf(stderr, "\n");
-    game->dPlayedRound = 0;
 }
 
 /**
@@ -325,29 +236,16 @@ int number_digits(int i) {
 }
 
 /**
- * Function to perform final checks of the played message received.
+ * Function to record a move made by another player and make our own move if
+ * it is our turn next.
  * @param game struct representing player's tracking of game.
- * @param input string representing message
  * @param newCard struct representing card played
  * @param justPlayed player number that just played.
  * @return 0 - no errors
- *         6 - message error.
- */
-int misc_played_checking(PlayerGame *game, char *input, Card *newCard,
-        int justPlayed) {
-    // check that card is of proper format
-    if (validate_card(input[0]) && (isdigit(input[1]) ||
-            (isalpha(input[1]) && isxdigit(input[1]) && islower(input[1])))) {
-        newCard->suit = input[0];
-        newCard->rank = input[1];
-        save_card(game, newCard);
-        game->cardPos += 1;
-    } else {
-        return show_player_message(MSGERR);
-    }
-    if (strlen(input) != 2) {
-        return show_player_message(MSGERR);
-    }
+ */
+int misc_played_checking(PlayerGame *game, Card *newCard, int justPlayed) {
+    save_card(game, newCard);
+    game->cardPos += 1;
 
     // if suit is D, increase how many D cards were played that round
     if (newCard->suit == 'D') {
@@ -383,63 +281,104 @@ int misc_played_checking(PlayerGame *game, char *input, Card *newCard,
  */
 int decode_played(char *input, PlayerGame *game) {
     input += 6;
-    char *oldInput = malloc(sizeof(char) * strlen(input));
-    strcpy(oldInput, input);
-    Card newCard;
-    input[strlen(input) - 1] = '\0';
-    int i = 0;
     // get player ID
-    while (input[i] != ',') {
-        if (!isdigit(input[i])) {
-            return show_player_message(MSGERR);
-        }
-        i++;
+    int digits = 0;
+    while (isdigit(input[digits])) {
+        digits++;
+    }
+    int justPlayed = digits > 0 && digits < 10 ? atoi(input) : -1;
+    if (input[digits] != ',' || digits != number_digits(justPlayed)) {
+        return show_player_message(MSGERR);
     }
-    char *playedID = malloc(i * sizeof(char));
-    strncpy(playedID, input, i);
-    int justPlayed = atoi(playedID);
 
-    // check msg length.
-    if (strlen(oldInput) != number_digits(justPlayed) + 4) {
+    // check that card is of proper format and ends the message
+    Card newCard;
+    int length = text_to_card(input + digits + 1, &newCard);
+    if (length == 0 || strcmp(input + digits + 1 + length, "\n") != 0) {
         return show_player_message(MSGERR);
     }
+    return apply_played(game, justPlayed, newCard);
+}
 
+/**
+ * Function to act on a played message once it has been decoded.
+ * @param game struct representing player's tracking of game.
+ * @param justPlayed player number that just played.
+ * @param newCard struct representing card played
+ * @return 0 - no errors
+ *         6 - error in message
+ */
+int apply_played(PlayerGame *game, int justPlayed, Card newCard) {
+    if (justPlayed >= game->playerCount) {
+        return show_player_message(MSGERR);
+    }
     // set next msg expected based on player ID
     if (justPlayed == (game->playerCount - 1)) {
         game->orderPos = 0;
         if (game->lastPlayer == justPlayed) {
-            set_expected(game, "HAND");
+            set_expected(game, PROTO_HAND);
         } else {
-            set_expected(game, "PLAYED");
+            set_expected(game, PROTO_PLAYED);
         }
     } else {
         game->orderPos++;
     }
-    game->cardsPlayed = malloc(game->handSize * game->playerCount * 2 *
-            sizeof(Card));
-
-    // remove prefix from string for easier checking
-    input += i;
-    input += 1;
-
     // perform further checks
-    int misc = misc_played_checking(game, input, &newCard, justPlayed);
-    if (misc != 0) {
-        return misc;
+    return misc_played_checking(game, &newCard, justPlayed);
+}
+
+/**
+ * Function to decode the newgame message from stdin, resetting the game for
+ * the next deal.
+ * @param input - string representing message
+ * @param game struct representing player's tracking of game.
+ * @return 0 - successfully decoded
+ *         6 - error in message
+ */
+int decode_newgame(char *input, PlayerGame *game) {
+    input += 7;
+    int i;
+    for (i = 0; input[i] != '\n' && input[i] != '\0'; i++) {
+        if (!isdigit(input[i])) {
+            return show_player_message(MSGERR);
+        }
+    }
+    if (i == 0) {
+        return show_player_message(MSGERR);
     }
+    return apply_newgame(game, atoi(input));
+}
 
+/**
+ * Function to reset the game for another deal of the given hand size.
+ * @param game struct representing player's tracking of game.
+ * @param handSize - number of cards in the next hand.
+ * @return 0 - game reset
+ *         6 - error in message
+ */
+int apply_newgame(PlayerGame *game, int handSize) {
+    // a new game is only valid once every card of the last one was played.
+    if (game->handSize != 0 || handSize < 1) {
+        return show_player_message(MSGERR);
+    }
+    game->handSize = handSize;
+    reset_expected(game);
     return DONE;
 }
 
 /**
  * Function to extract the player portion of the played message.
  * @param input - string representing message
+ * @param scratch - arena for the copy of the message.
  * @return 0 - successfully decoded
  *         6 - error in message
  */
-int extract_last_player(char *input) {
-    char *dest = malloc(sizeof(char) * strlen(input));
-    strncpy(dest, input, strlen(input));
+int extract_last_player(char *input, Arena *scratch) {
+    char *dest = arena_alloc(scratch, strlen(input) + 1);
+    if (dest == NULL) {
+        return -1;
+    }
+    strcpy(dest, input);
     // remove PLAYED portion
     dest += 6;
     int i = 0;
@@ -456,6 +395,47 @@ int extract_last_player(char *input) {
     return atoi(dest);
 }
 
+/**
+ * Function to find the type of a message in a single pass over its prefix.
+ * @param input - string representing message
+ * @return the type of the message, MSG_INVALID if it is not recognised.
+ */
+MessageType message_type(const char *input) {
+    switch (input[0]) {
+        case 'H':
+            if (strncmp(input + 1, "AND", 3) == 0) {
+                return MSG_HAND;
+            }
+            break;
+        case 'N':
+            // NEWROUND and NEWGAME share their first three characters
+            if (strncmp(input + 1, "EW", 2) != 0) {
+                break;
+            }
+            if (strncmp(input + 3, "ROUND", 5) == 0) {
+                return MSG_NEWROUND;
+            } else if (strncmp(input + 3, "GAME", 4) == 0) {
+                return MSG_NEWGAME;
+            }
+            break;
+        case 'P':
+            // PLAYED (hub to player) and PLAY (player to hub)
+            if (strncmp(input + 1, "LAY", 3) != 0) {
+                break;
+            }
+            if (input[4] == 'E' && input[5] == 'D') {
+                return MSG_PLAYED;
+            }
+            return MSG_PLAY;
+        case 'G':
+            if (strncmp(input + 1, "AMEOVER", 7) == 0) {
+                return MSG_GAMEOVER;
+            }
+            break;
+    }
+    return MSG_INVALID;
+}
+
 /**
  * Function to decide what the player will do based on input from hub.
  * @param input - string from stdin.
@@ -464,52 +444,157 @@ int extract_last_player(char *input) {
  *         6 - invalid message from the hub.
  */
 int process_input(char *input, PlayerGame *game) {
-    char *dest = malloc(sizeof(char) * strlen(input));
-    if (strncmp(input, "HAND", 4) == 0) {
-        strncpy(dest, input, 4);
-        dest[4] = 0;
-        // check that hand should be arriving now
-        int msgCheck = check_expected(game, dest, game->playerMove);
-        if (msgCheck != 0) {
-            return msgCheck;
-        }
-        int decode = decode_hand(input, game);
-        if (decode != 0) {
-            return decode;
-        }
-    } else if (strncmp(input, "NEWROUND", 8) == 0) {
+    // decoders for the messages a player can receive, by message type
+    static int (*const decoders[HUB_MESSAGES])(char *, PlayerGame *) = {
+            [MSG_HAND] = decode_hand,
+            [MSG_NEWROUND] = decode_newround,
+            [MSG_PLAYED] = decode_played,
+            [MSG_NEWGAME] = decode_newgame,
+            [MSG_GAMEOVER] = 0};
+    MessageType type = message_type(input);
+    if (type == MSG_GAMEOVER) {
+        // clean return (exit with 0)
+        return 0;
+    } else if (type >= HUB_MESSAGES) {
+        return show_player_message(MSGERR);
+    }
+    if (type == MSG_NEWROUND) {
         game->expected = 0;
-        strncpy(dest, input, 8);
-        dest[8] = 0;
-        // check that newround should be arriving now
-        int msgCheck = check_expected(game, dest, game->playerMove);
-        if (msgCheck != 0) {
-            return msgCheck;
+    } else if (type == MSG_PLAYED) {
+        game->playerMove = extract_last_player(input, &game->scratch);
+    }
+    // check that this message should be arriving now
+    int msgCheck = check_expected(game, type, game->playerMove);
+    if (msgCheck != 0) {
+        return msgCheck;
+    }
+    return decoders[type](input, game);
+}
+
+/**
+ * Function to read a little endian 16 bit number from stdin.
+ * @param value - where to store the number.
+ * @return 1 if read, 0 on EOF.
+ */
+int read_wire_number(int *value) {
+    unsigned char bytes[2];
+    if (fread(bytes, 1, 2, stdin) != 2) {
+        return 0;
+    }
+    *value = bytes[0] | bytes[1] << 8;
+    return 1;
+}
+
+/**
+ * Function to read the rest of a binary record from stdin and act on it. No
+ * text is parsed, the payload goes straight to the same handlers used by the
+ * text decoders.
+ * @param type - the record type byte already read.
+ * @param game struct representing player's tracking of game.
+ * @return 0 - no errors
+ *         6 - invalid message from the hub
+ *         7 - EOF from hub part way through a record
+ */
+int process_record(int type, PlayerGame *game) {
+    // message type for each record type, for ordering checks
+    static const MessageType types[] = {
+            [WIRE_HAND] = MSG_HAND,
+            [WIRE_NEWROUND] = MSG_NEWROUND,
+            [WIRE_PLAYED] = MSG_PLAYED,
+            [WIRE_NEWGAME] = MSG_NEWGAME};
+    int number;
+    unsigned char wire[64];
+    if (type < WIRE_HAND || type > WIRE_NEWGAME) {
+        return show_player_message(MSGERR);
+    }
+    if (!read_wire_number(&number)) {
+        return show_player_message(EOFERR);
+    }
+    if (type == WIRE_PLAYED) {
+        if (fread(wire, 1, 1, stdin) != 1) {
+            return show_player_message(EOFERR);
         }
-        int decode = decode_newround(input, game);
-        if (decode != 0) {
-            return decode;
+        game->playerMove = number;
+    }
+    if (type == WIRE_HAND) {
+        if (number != game->handSize) {
+            return show_player_message(MSGERR);
         }
-    } else if (strncmp(input, "PLAYED", 6) == 0) {
-        game->playerMove = extract_last_player(input);
-        strncpy(dest, input, 6);
-        dest[6] = 0;
-        // check that played should be arriving now
-        int msgCheck = check_expected(game, dest, game->playerMove);
-        if (msgCheck != 0) {
-            return msgCheck;
+        // the cards go into our hand as they are read, a shoe may deal
+        // several copies of one
+        hand_clear(&game->hand);
+        for (int i = 0; i < number; i += sizeof(wire)) {
+            int chunk = number - i < sizeof(wire) ? number - i : sizeof(wire);
+            if (fread(wire, 1, chunk, stdin) != chunk) {
+                return show_player_message(EOFERR);
+            }
+            for (int j = 0; j < chunk; j++) {
+                hand_add(&game->hand, wire_to_card(wire[j]));
+            }
         }
-        int decode = decode_played(input, game);
-        if (decode != 0) {
-            return decode;
+    }
+    // check that this message should be arriving now
+    int msgCheck = check_expected(game, types[type], game->playerMove);
+    if (msgCheck != 0) {
+        return msgCheck;
+    }
+    switch (type) {
+        case WIRE_HAND:
+            return DONE;
+        case WIRE_NEWROUND:
+            game->expected = 0;
+            return apply_newround(game, number);
+        case WIRE_PLAYED:
+            return apply_played(game, number, wire_to_card(wire[0]));
+        default:
+            return apply_newgame(game, number);
+    }
+}
+
+/**
+ * Function to read binary records from stdin until gameover.
+ * @param game struct representing player's tracking of game.
+ * @return 0 - clean exit
+ *         6 - error in hub message
+ *         7 - EOF from hub
+ */
+int cont_read_records(PlayerGame *game) {
+    int type;
+    while ((type = getchar()) != WIRE_GAMEOVER) {
+        if (type == EOF) {
+            return show_player_message(EOFERR);
         }
-    } else if (strncmp(input, "GAMEOVER", 8) == 0) {
-        // clean return (exit with 0)
-        return 0;
-    } else {
-        return show_player_message(MSGERR);
+        int processed = process_record(type, game);
+        if (processed != 0) {
+            return processed;
+        }
+    }
+    return DONE;
+}
+
+/**
+ * Function to tell the hub we are ready, accepting the binary protocol,
+ * multiplexing or shared memory if the hub offered them. Once shared memory
+ * is accepted stdin and stdout use its rings.
+ * @param game struct representing player's tracking of game.
+ */
+void send_ready(PlayerGame *game) {
+    char *wire = getenv(WIRE_ENV);
+    char *mux = getenv(MUX_ENV);
+    char *shm = getenv(SHM_ENV);
+    game->mux = mux && strcmp(mux, "1") == 0;
+    game->binary = !game->mux && wire && strcmp(wire, "binary") == 0;
+    ShmLink *link = !game->mux && shm && isdigit(*shm)
+            ? shm_attach(atoi(shm)) : NULL;
+    FILE *pipe = stdout;
+    int rings = link && shm_use_stdio(link);
+    if (link && !rings) {
+        shm_release(link);
     }
-    return 0;
+    // output @ for hub recognition, all bytes in one write.
+    fprintf(pipe, "%s%s", game->mux ? "@M" : game->binary ? "@B" : "@",
+            rings ? "S" : "");
+    fflush(pipe);
 }
 
 /**
@@ -520,27 +605,118 @@ int process_input(char *input, PlayerGame *game) {
  *         7 - EOF from hub
  */
 int cont_read_stdin(PlayerGame *game) {
-    char input[LINESIZE];
-    fgets(input, BUFSIZ, stdin);
+    if (game->mux) {
+        return cont_read_mux(game);
+    } else if (game->binary) {
+        return cont_read_records(game);
+    }
+    // each line is read whole however long it is, the buffer grows to fit
+    char *input = NULL;
+    size_t size = 0;
+    ssize_t length = getline(&input, &size, stdin);
     // keep reading until gameover or EOF from hub
-    while (strcmp(input, "GAMEOVER\n") != 0 && !feof(stdin)) {
+    while (length > 0 && input[length - 1] == '\n'
+            && strcmp(input, "GAMEOVER\n") != 0) {
         // decide what to do on message
         int processed = process_input(input, game);
         if (processed != 0) {
+            free(input);
             return processed;
         }
+        // nothing decoded from a message outlives it
+        arena_reset(&game->scratch);
         // get next message
-        fgets(input, BUFSIZ, stdin);
+        length = getline(&input, &size, stdin);
     }
-    if (feof(stdin)) {
-        // return EOF if end of file.
+    int gameover = length > 0 && strcmp(input, "GAMEOVER\n") == 0;
+    free(input);
+    if (!gameover) {
+        // return EOF if end of file, even part way through a line.
         return show_player_message(EOFERR);
     }
     return DONE;
 }
 
 /**
- * Function to send message to hub as to  what card was played.
+ * Function to read tagged lines from a multiplexed hub, playing at every
+ * table from one process. Tables are kept in an array indexed by their tag
+ * and each starts as a copy of first when its first line arrives. Its hand
+ * size comes from its first HAND, since tables may start on different deals.
+ * Moves are collected from the table's game and sent with the same tag.
+ * @param first struct representing player's arguments, copied for each table.
+ * @return 0 - never, the hub ends multiplexed players
+ *         6 - error in hub message
+ *         7 - EOF from hub
+ */
+int cont_read_mux(PlayerGame *first) {
+    PlayerGame *tables = NULL;
+    int tableCount = 0;
+    char *input = NULL;
+    size_t size = 0;
+    ssize_t length;
+    // lines are read whole, a partial line means the hub has gone
+    while ((length = getline(&input, &size, stdin)) > 0
+            && input[length - 1] == '\n') {
+        char *message;
+        long tag = strtol(input, &message, 10);
+        if (message == input || *message != ':' || tag < 0
+                || tag > INT_MAX / 2) {
+            return show_player_message(MSGERR);
+        }
+        message++;
+        if (strcmp(message, "GAMEOVER\n") == 0) {
+            continue; // no more games at that table
+        }
+        if (tag >= tableCount) {
+            int count = tableCount ? tableCount : 16;
+            while (count <= tag) {
+                count *= 2;
+            }
+            tables = realloc(tables, count * sizeof(PlayerGame));
+            if (!tables) {
+                return show_player_message(MSGERR);
+            }
+            // a table with no strategy has not started yet
+            for (int t = tableCount; t < count; t++) {
+                tables[t].playerStrategy = NULL;
+            }
+            tableCount = count;
+        }
+        PlayerGame *game = &tables[tag];
+        if (!game->playerStrategy) {
+            *game = *first;
+            if (message_type(message) == MSG_HAND) {
+                game->handSize = atoi(message + 4);
+                if (game->handSize < 1 || game->handSize > HAND_MAX) {
+                    return show_player_message(MSGERR);
+                }
+            }
+            if (init_expected(game) != DONE) {
+                return MSGERR;
+            }
+            game->simulated = 1;
+            use_plugin(game, first->plugin); // each table has its own state
+        }
+        int processed = process_input(message, game);
+        if (processed != 0) {
+            return processed;
+        }
+        arena_reset(&game->scratch);
+        if (game->moved) {
+            game->moved = 0;
+            char text[CARD_TEXT_SIZE];
+            printf("%ld:PLAY%.*s\n", tag, card_to_text(game->chosen, text),
+                    text);
+            fflush(stdout);
+        }
+    }
+    free(input);
+    return show_player_message(EOFERR);
+}
+
+/**
+ * Function to send message to hub as to  what card was played. Simulated
+ * players record the card in game->chosen instead.
  * @param game struct representing player's tracking of game.
  * @return 0 when done.
  */
@@ -552,12 +728,116 @@ void play_card(PlayerGame *game, Card *play) {
     }
     game->cardPos += 1;
     // output
-    printf("PLAY%c%c\n", play->suit, play->rank);
-    fflush(stdout);
+    if (game->simulated) {
+        // the caller collects the card and plays it for us
+        game->chosen = *play;
+        game->moved = 1;
+    } else {
+        if (game->binary) {
+            putchar(WIRE_PLAY);
+            putchar(card_to_wire(*play));
+        } else {
+            char text[CARD_TEXT_SIZE];
+            printf("PLAY%.*s\n", card_to_text(*play, text), text);
+        }
+        fflush(stdout);
+    }
     // remove from hand, so we cant play again.
     remove_card(game, play);
 }
 
+/**
+ * Function to have a player make its moves with a strategy plug-in, opening
+ * the plug-in for the player's seat.
+ * @param game struct representing player's tracking of game.
+ * @param plugin - plug-in to use.
+ */
+void use_plugin(PlayerGame *game, const StrategyPlugin *plugin) {
+    game->plugin = plugin;
+    game->playerStrategy = plugin_move;
+    game->pluginState = plugin->open ? plugin->open(game->playerCount,
+            game->myID, game->threshold) : NULL;
+}
+
+/**
+ * Function to tell a player's strategy plug-in the seat is done.
+ * @param game struct representing player's tracking of game.
+ */
+void release_plugin(PlayerGame *game) {
+    if (game->plugin && game->plugin->close) {
+        game->plugin->close(game->pluginState);
+    }
+    game->pluginState = NULL;
+}
+
+/**
+ * Function to make our move by showing the game to a strategy plug-in and
+ * playing the card it picks. A card which is not held is still played, for
+ * the hub to reject, but one which is not a card at all ends the player.
+ * @param game struct representing player's tracking of game.
+ * @return 0 when done
+ *         8 - a simulated player's plug-in did not pick a card.
+ */
+int plugin_move(PlayerGame *game) {
+    uint8_t played[game->playerCount];
+    for (int i = 0; i < game->cardPos; i++) {
+        played[i] = card_code(game->roundCards[i]);
+    }
+    int leading = game->leadPlayer == game->myID && game->cardPos == 0;
+    StrategyView view = {game->playerCount, game->myID, game->threshold,
+            game->handSize, game->hand.held, game->hand.copies,
+            game->seen.held, game->seen.copies, game->leadPlayer,
+            leading ? -1 : suit_index(game->leadSuit), game->cardPos, played,
+            game->dPlayerNumber, game->dPlayedRound, game->pluginState};
+    int code = game->plugin->choose(&view);
+    if (code < 0 || code >= CARD_CODES) {
+        if (game->simulated && !game->mux) {
+            return STRATEGYERR; // 2310sim sees that no move was made
+        }
+        exit(show_player_message(STRATEGYERR));
+    }
+    Card card = wire_to_card(code);
+    play_card(game, &card);
+    return DONE;
+}
+
+/**
+ * Function to run a player program: check its arguments, tell the hub it is
+ * ready and play every game with a strategy plug-in until gameover.
+ * @param argc - number of arguments supplied at command line.
+ * @param argv - array of strings supplied at startup.
+ * @param plugin - strategy to play with.
+ * @return 0 - normal exit
+ *         1 - incorrect number of arguments
+ *         2 - number of players < 2 or not a number
+ *         3 - invalid position for number of players
+ *         4 - threshold < 2 or not a number
+ *         6 - invalid message from hub.
+ *         7 - unexpected EOF from hub.
+ */
+int run_player(int argc, char **argv, const StrategyPlugin *plugin) {
+    if (argc != 5) {
+        // incorrect arg count.
+        return show_player_message(ARGERR);
+    }
+    PlayerGame game;
+    int parseStatus = parse_player(argc, argv, &game);
+    if (parseStatus != 0) {
+        return parseStatus;
+    }
+    int initStatus = init_expected(&game);
+    if (initStatus != DONE) {
+        return initStatus;
+    }
+
+    // output @ for hub recognition
+    send_ready(&game);
+
+    // make moves with the plug-in and wait for hub input
+    use_plugin(&game, plugin);
+    return cont_read_stdin(&game);
+}
+
 /**
  * Function to perform further argument checking for player.
  * @param argc - number of arguments
@@ -570,7 +850,7 @@ void play_card(PlayerGame *game, Card *play) {
  */
 int further_arg_checks(int argc, char **argv, PlayerGame *game) {
     // check threshold
-    char *thresholdArg = malloc(sizeof(char) * strlen(argv[3]));
+    char *thresholdArg = calloc(strlen(argv[3]) + 1, sizeof(char));
     if (strlen(argv[3]) == 0) {
         return show_player_message(PLAYERERR);
     }
@@ -593,7 +873,7 @@ int further_arg_checks(int argc, char **argv, PlayerGame *game) {
     }
 
     // hand size
-    char *handArg = malloc(sizeof(char) * strlen(argv[4]));
+    char *handArg = calloc(strlen(argv[4]) + 1, sizeof(char));
     if (strlen(argv[4]) == 0) {
         return show_player_message(PLAYERERR);
     }
@@ -611,7 +891,7 @@ int further_arg_checks(int argc, char **argv, PlayerGame *game) {
     }
     sscanf(handArg, "%d", &game->handSize);
     free(handArg);
-    if (game->handSize < 1) {
+    if (game->handSize < 1 || game->handSize > HAND_MAX) {
         return show_player_message(HANDERR);
     }
     return DONE;
@@ -629,7 +909,7 @@ int further_arg_checks(int argc, char **argv, PlayerGame *game) {
  */
 int parse_player(int argc, char **argv, PlayerGame *game) {
     // check playerCount
-    char *countArg = malloc(sizeof(char) * strlen(argv[1]));
+    char *countArg = calloc(strlen(argv[1]) + 1, sizeof(char));
     if (strlen(argv[1]) == 0) {
         return show_player_message(PLAYERERR);
     }
@@ -651,7 +931,7 @@ int parse_player(int argc, char **argv, PlayerGame *game) {
     }
 
     // check playerID
-    char *idArg = malloc(sizeof(char) * strlen(argv[2]));
+    char *idArg = calloc(strlen(argv[2]) + 1, sizeof(char));
     if (strlen(argv[2]) == 0) {
         return show_player_message(PLAYERERR);
     }
@@ -681,95 +961,104 @@ int parse_player(int argc, char **argv, PlayerGame *game) {
 /**
  * Function to set the next expected msg from hub.
  * @param game struct representing player's tracking of game.
- * @param set string representing state.
+ * @param set state to move to.
  */
-void set_expected(PlayerGame *game, char *set) {
+void set_expected(PlayerGame *game, ProtocolState set) {
     game->current = set;
 }
 
 /**
  * Function to check the msg received from the hub to ensure correct ordering.
  * @param game struct representing player's tracking of game.
- * @param got string that the hub sent.
+ * @param got type of the message the hub sent.
  * @param currentPlayer integer representing the current player playing.
  * @return 0 - no error
  *         6 - invalid message from hub.
  */
-int check_expected(PlayerGame *game, char *got, int currentPlayer) {
-    if (strcmp(game->current, "start") == 0) {
-        /* BEGINNING STATE */
-        // we expect HAND - we want to start the game
-        if (strcmp(got, "HAND") != 0) {
-            return show_player_message(MSGERR);
-        }
-        // expected next state to be newround
-        set_expected(game, "HAND");
-
-    } else if (strcmp(game->current, "HAND") == 0) {
-        /* HAND STATE */
-        // we expect the next to be newround to start the game
-        if (strcmp(got, "NEWROUND") != 0) {
-            return show_player_message(MSGERR);
-        }
-        set_expected(game, "NEWROUND");
-
-    } else if (strcmp(game->current, "NEWROUND") == 0) {
-        /* NEWROUND STATE */
-        //we expect to get a played message
-        if (strcmp(got, "PLAYED") != 0) {
-            return show_player_message(MSGERR);
-        }
-        // expect next state to be another move
-        set_expected(game, "PLAYED");
+int check_expected(PlayerGame *game, MessageType got, int currentPlayer) {
+    // next state for each state and message, PROTO_ERROR if out of order
+    static const ProtocolState transitions[PROTO_STATES][HUB_MESSAGES] = {
+            [PROTO_START] = {PROTO_HAND, PROTO_ERROR, PROTO_ERROR,
+                    PROTO_ERROR, PROTO_START},
+            [PROTO_HAND] = {PROTO_ERROR, PROTO_NEWROUND, PROTO_ERROR,
+                    PROTO_START, PROTO_START},
+            [PROTO_NEWROUND] = {PROTO_ERROR, PROTO_ERROR, PROTO_PLAYED,
+                    PROTO_ERROR, PROTO_START},
+            [PROTO_PLAYED] = {PROTO_ERROR, PROTO_PLAYED, PROTO_PLAYED,
+                    PROTO_START, PROTO_START}};
+    ProtocolState next = transitions[game->current][got];
+    if (next == PROTO_ERROR) {
+        return show_player_message(MSGERR);
+    }
+    // after the last player of the round has moved we wait for a new round
+    if (next == PROTO_PLAYED && got == MSG_PLAYED
+            && game->playerCount - 1 == currentPlayer
+            && game->lastPlayer == currentPlayer) {
+        next = PROTO_HAND;
+    }
+    set_expected(game, next);
+    return DONE;
+}
 
-    } else if (strcmp(got, "PLAYED") == 0) {
-        /* PLAYED STATE */
-        if (strcmp(got, "PLAYED") != 0) {
-            return show_player_message(MSGERR);
-        }
-        if (game->playerCount - 1 == currentPlayer) {
-            if (game->lastPlayer == currentPlayer) {
-                set_expected(game, "HAND");
-            } else {
-                set_expected(game, "PLAYED");
-            }
-            return DONE;
+/**
+ * Function to set up state handling along with initialisation of variables.
+ * @param game struct representing player's tracking of game.
+ * @return 0 - set up
+ *         6 - the player's storage could not be allocated.
+ */
+int init_expected(PlayerGame *game) {
+    // the only allocations a player makes, everything else comes from these
+    memset(&game->storage, 0, sizeof(Arena));
+    if (!arena_init(&game->scratch, PLAYER_SCRATCH_SIZE)
+            || init_game_storage(game) != DONE) {
+        arena_free(&game->scratch);
+        arena_free(&game->storage);
+        return show_player_message(MSGERR);
+    }
+    game->simulated = 0;
+    game->moved = 0;
+    // hands only clear the copies they know they hold
+    memset(&game->hand, 0, sizeof(CardHand));
+    memset(&game->seen, 0, sizeof(CardHand));
+    reset_expected(game);
+    return DONE;
+}
 
-        }
-        // expected current to be another move
-        set_expected(game, "PLAYED");
+/**
+ * Function to carve the storage a player keeps for every game out of its
+ * arena. It only depends on the player count, so games of any hand size
+ * reuse the same block.
+ * @param game struct representing player's tracking of game.
+ * @return 0 - storage carved
+ *         6 - it could not be allocated.
+ */
+int init_game_storage(PlayerGame *game) {
+    int count = game->playerCount;
+    // each allocation may be padded by up to ARENA_ALIGN bytes
+    size_t needed = count * sizeof(Card) + count * sizeof(int)
+            + 2 * ARENA_ALIGN;
+    if (!arena_init(&game->storage, needed)) {
+        return MSGERR;
     }
+    game->roundCards = arena_alloc(&game->storage, count * sizeof(Card));
+    game->dPlayerNumber = arena_alloc(&game->storage, sizeof(int) * count);
     return DONE;
 }
 
 /**
- * Function to set up state handling along with initialisation of variables.
+ * Function to reset the state of a game without reallocating its storage, so
+ * the same player process can play another game.
  * @param game struct representing player's tracking of game.
  */
-void init_expected(PlayerGame *game) {
+void reset_expected(PlayerGame *game) {
     // setup variables used for the game
-    game->current = "start";
-    game->round = 0;
+    game->current = PROTO_START;
     game->firstRound = 1;
     game->cardPos = 0;
-
-    // malloc various storages
-    game->cardsStored = (char **) malloc(game->playerCount * sizeof(char *));
-    for (int j = 0; j < game->playerCount; j++) {
-        game->cardsStored[j] = malloc(4 * sizeof(char));
-    }
-    game->order = malloc(sizeof(int) * (game->playerCount - 1));
     game->orderPos = 0;
     game->dPlayedRound = 0;
-    game->dPlayerNumber = malloc(sizeof(int) * game->playerCount);
+    hand_clear(&game->seen);
     for (int i = 0; i < game->playerCount; i++) {
         game->dPlayerNumber[i] = 0;
     }
-
-    // store order for players
-    int i;
-    for (i = 0; i < game->playerCount; i++) {
-        game->order[i] = i;
-    }
-    game->largestPlayer = i;
 }
\ No newline at end of file
@@ -1,14 +1,261 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+#include "shmring.h"
+#include "strategy_abi.h"
 
 #ifndef SHARED_H
 #define SHARED_H
 
 // struct for card
 typedef struct {
-    char rank;
+    unsigned char rank; // 0 - CARD_RANKS - 1, written in lowercase hex.
     char suit;
 } Card;
 
+// most characters in a card's text, its suit and two hex digits of rank
+#define CARD_TEXT_SIZE 3
+
+// most cards in a hand, binary records count them in 16 bits
+#define HAND_MAX 0xFFFF
+
+/**
+ * Function to get the position of a suit within a CardSet.
+ * @param suit - char representing the suit.
+ * @return 0 - 3 for S, C, D, H respectively, -1 if not a suit.
+ */
+static inline int suit_index(char suit) {
+    switch (suit) {
+        case 'S':
+            return 0;
+        case 'C':
+            return 1;
+        case 'D':
+            return 2;
+        case 'H':
+            return 3;
+    }
+    return -1;
+}
+
+/**
+ * Function to get the value of a hex digit of a rank.
+ * @param digit - char to read, 0-9 or a-f.
+ * @return 0 - 15, or -1 if not a lowercase hex digit.
+ */
+static inline int rank_digit(char digit) {
+    if (digit >= '0' && digit <= '9') {
+        return digit - '0';
+    } else if (digit >= 'a' && digit <= 'f') {
+        return digit - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * Function to get the code of a card (see strategy_abi.h), which is also its
+ * bit in a CardSet and its byte in the binary protocol.
+ * @param card - card to find.
+ * @return 0 - CARD_CODES - 1.
+ */
+static inline int card_code(Card card) {
+    return suit_index(card.suit) * CARD_RANKS + card.rank;
+}
+
+/**
+ * Function to make the card for a suit and rank position in a CardSet.
+ * @param suit - 0 - 3 for S, C, D, H respectively.
+ * @param rank - 0 - CARD_RANKS - 1.
+ * @return the card.
+ */
+static inline Card card_at(int suit, int rank) {
+    Card card;
+    card.suit = "SCDH"[suit];
+    card.rank = rank;
+    return card;
+}
+
+/**
+ * Function to write a card as text, its suit then its rank in lowercase hex.
+ * @param card - card to write.
+ * @param text - room for CARD_TEXT_SIZE chars, which are not terminated.
+ * @return number of chars written.
+ */
+static inline int card_to_text(Card card, char *text) {
+    const char *digits = "0123456789abcdef";
+    int length = 0;
+    text[length++] = card.suit;
+    if (card.rank > 0xF) {
+        text[length++] = digits[card.rank >> 4];
+    }
+    text[length++] = digits[card.rank & 0xF];
+    return length;
+}
+
+/**
+ * Function to read a card written by card_to_text. A rank of two digits
+ * cannot start with 0, so each card has one way to be written. The caller
+ * checks what follows the card.
+ * @param text - text starting with the card.
+ * @param card - card to fill in.
+ * @return number of chars read, 0 if the text does not start with a card.
+ */
+static inline int text_to_card(const char *text, Card *card) {
+    int first = rank_digit(text[1]);
+    if (suit_index(text[0]) < 0 || first < 0) {
+        return 0;
+    }
+    int second = rank_digit(text[2]);
+    card->suit = text[0];
+    if (first > 0 && second >= 0 && first * 16 + second < CARD_RANKS) {
+        card->rank = first * 16 + second;
+        return 3;
+    }
+    card->rank = first;
+    return 2;
+}
+
+/**
+ * Function to make an empty set.
+ * @return the set.
+ */
+static inline CardSet card_set_empty(void) {
+    CardSet set = {{0}};
+    return set;
+}
+
+/**
+ * Function to check if a card is in a set.
+ * @return 1 if present, 0 if not.
+ */
+static inline int card_set_has(CardSet set, Card card) {
+    return (set.suits[suit_index(card.suit)] >> card.rank) & 1;
+}
+
+/**
+ * Function to add a card to a set.
+ */
+static inline void card_set_add(CardSet *set, Card card) {
+    set->suits[suit_index(card.suit)] |= (uint64_t) 1 << card.rank;
+}
+
+/**
+ * Function to remove a card from a set.
+ */
+static inline void card_set_remove(CardSet *set, Card card) {
+    set->suits[suit_index(card.suit)] &= ~((uint64_t) 1 << card.rank);
+}
+
+/**
+ * Function to count the cards in a set.
+ */
+static inline int card_set_count(CardSet set) {
+    int count = 0;
+    for (int suit = 0; suit < CARD_SUITS; suit++) {
+        count += __builtin_popcountll(set.suits[suit]);
+    }
+    return count;
+}
+
+/**
+ * Function to get the ranks held in one suit of a set.
+ * @param set - set of cards.
+ * @param suit - 0 - 3 for S, C, D, H respectively.
+ * @return mask with bit n set if rank n is held.
+ */
+static inline uint64_t card_set_suit(CardSet set, int suit) {
+    return set.suits[suit];
+}
+
+/**
+ * Function to get the lowest rank held in a suit.
+ * @return 0 - CARD_RANKS - 1, or -1 if the suit is empty.
+ */
+static inline int card_set_lowest(CardSet set, int suit) {
+    uint64_t ranks = card_set_suit(set, suit);
+    return ranks ? __builtin_ctzll(ranks) : -1;
+}
+
+/**
+ * Function to get the highest rank held in a suit.
+ * @return 0 - CARD_RANKS - 1, or -1 if the suit is empty.
+ */
+static inline int card_set_highest(CardSet set, int suit) {
+    uint64_t ranks = card_set_suit(set, suit);
+    return ranks ? 63 - __builtin_clzll(ranks) : -1;
+}
+
+/**
+ * Function to find the first suit in the given order with a card in a set.
+ * @param set - set of cards.
+ * @param order - string of suits in the order to search.
+ * @return 0 - 3 for S, C, D, H respectively, -1 if the set is empty.
+ */
+static inline int card_set_first_suit(CardSet set, const char *order) {
+    for (; *order; order++) {
+        if (card_set_suit(set, suit_index(*order)) != 0) {
+            return suit_index(*order);
+        }
+    }
+    return -1;
+}
+
+// struct for cards which may include several copies of a card, from a shoe
+typedef struct {
+    CardSet held; // each card held at least once.
+    int extra; // copies held beyond the first, of every card.
+    uint16_t copies[CARD_CODES]; // [code] copies held beyond the first.
+} CardHand;
+
+/**
+ * Function to empty a hand, only touching the copies if it had any.
+ */
+static inline void hand_clear(CardHand *hand) {
+    hand->held = card_set_empty();
+    if (hand->extra) {
+        memset(hand->copies, 0, sizeof(hand->copies));
+        hand->extra = 0;
+    }
+}
+
+/**
+ * Function to check if a hand holds a card.
+ * @return 1 if held, 0 if not.
+ */
+static inline int hand_has(const CardHand *hand, Card card) {
+    return card_set_has(hand->held, card);
+}
+
+/**
+ * Function to add a card to a hand, as another copy if it is already held.
+ */
+static inline void hand_add(CardHand *hand, Card card) {
+    if (card_set_has(hand->held, card)) {
+        hand->copies[card_code(card)]++;
+        hand->extra++;
+    } else {
+        card_set_add(&hand->held, card);
+    }
+}
+
+/**
+ * Function to take a card from a hand, leaving any other copies.
+ * @return 1 if the card was held, 0 if not.
+ */
+static inline int hand_remove(CardHand *hand, Card card) {
+    int code = card_code(card);
+    if (hand->copies[code]) {
+        hand->copies[code]--;
+        hand->extra--;
+    } else if (card_set_has(hand->held, card)) {
+        card_set_remove(&hand->held, card);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
 // enum for exit status of player
 typedef enum {
     DONE = 0,
@@ -18,9 +265,85 @@ typedef enum {
     THRESHERR = 4,
     HANDERR = 5,
     MSGERR = 6,
-    EOFERR = 7
+    EOFERR = 7,
+    STRATEGYERR = 8
 } PlayerStatus;
 
+// enum for the type of a protocol message, found in a single pass
+typedef enum {
+    MSG_HAND = 0,
+    MSG_NEWROUND = 1,
+    MSG_PLAYED = 2,
+    MSG_NEWGAME = 3,
+    MSG_GAMEOVER = 4,
+    MSG_PLAY = 5,
+    MSG_INVALID = 6
+} MessageType;
+
+// number of message types the hub sends to players
+#define HUB_MESSAGES 5
+
+// enum for the protocol state of a player, indexes the transition table
+typedef enum {
+    PROTO_ERROR = -1,
+    PROTO_START = 0, // waiting for our hand
+    PROTO_HAND = 1, // have our hand, waiting for a round to start
+    PROTO_NEWROUND = 2, // round started, waiting for the first move
+    PROTO_PLAYED = 3, // moves are being made
+} ProtocolState;
+
+// number of protocol states a player can be in
+#define PROTO_STATES 4
+
+/*
+ * Records of the binary wire protocol, used instead of text lines when a
+ * player answers the hub's offer (HUB_WIRE=binary in its environment) with
+ * "@B". Numbers are 16 bit little endian and each card is one byte, its
+ * code, see card_to_wire().
+ *   HAND     [type][count][count card bytes]
+ *   NEWROUND [type][lead player]
+ *   PLAYED   [type][player][card]
+ *   NEWGAME  [type][hand size]
+ *   GAMEOVER [type]
+ *   PLAY     [type][card]        (player to hub)
+ */
+#define WIRE_HAND 0x01
+#define WIRE_NEWROUND 0x02
+#define WIRE_PLAYED 0x03
+#define WIRE_NEWGAME 0x04
+#define WIRE_GAMEOVER 0x05
+#define WIRE_PLAY 0x06
+
+// environment variable the hub uses to offer the binary protocol
+#define WIRE_ENV "HUB_WIRE"
+
+/*
+ * Multiplexed players serve one seat at every table of a hub started with
+ * --mux, and answer its offer (HUB_MUX=1 in their environment) with "@M".
+ * Each text line in either direction then starts with its table number and a
+ * ':', as in "3:HAND2,S1,Ha" and "3:PLAYS1".
+ */
+#define MUX_ENV "HUB_MUX"
+
+/**
+ * Function to encode a card as a single byte, its code, so suit index in the
+ * top two bits and rank in the rest.
+ * @param card - card to encode.
+ * @return the encoded card.
+ */
+static inline unsigned char card_to_wire(Card card) {
+    return card_code(card);
+}
+
+/**
+ * Function to decode a card byte, every byte being the code of a card.
+ * @param wire - byte to decode.
+ * @return the card.
+ */
+static inline Card wire_to_card(unsigned char wire) {
+    return card_at(wire / CARD_RANKS, wire % CARD_RANKS);
+}
+
 // struct for deck
 typedef struct {
     unsigned int count;
@@ -28,14 +351,22 @@ typedef struct {
     Card *contents;
 } Deck;
 
+// size of the buffer holding unread bytes from a player
+#define PLAYER_INPUT_SIZE 128
+
 // struct for player
 typedef struct {
-    unsigned int size;
-    Card cards[60]; //max number of cards for one player (15 * 4 suits)
     int *pipeIn;
     int *pipeOut;
-    FILE *fileIn;
-    FILE *fileOut;
+    char *output; // messages queued for pipeIn, written in one go
+    int outputLength;
+    int outputSize;
+    char input[PLAYER_INPUT_SIZE]; // bytes read from pipeOut not yet used
+    int inputLength;
+    int binary; // 1 if the player accepted the binary protocol.
+    int tag; // table number each line starts with, -1 if not multiplexed.
+    ShmLink *link; // memory shared with the player, NULL if not offered.
+    int shm; // 1 if the player accepted the rings of link instead of pipes.
 } Player;
 
 // struct for particular play of a card
@@ -44,9 +375,12 @@ typedef struct {
     Card card;
 } Play;
 
+// bytes of scratch storage a player has for decoding one message
+#define PLAYER_SCRATCH_SIZE 1024
+
 // struct for player's record of the game.
 typedef struct {
-    Card hand[60];
+    CardHand hand;
     int handSize;
     unsigned int playerMove; // will be 0 - playerNumber
     int myID;
@@ -55,24 +389,30 @@ typedef struct {
     int leadPlayer;
     char leadSuit;
 
-    char *current;
+    ProtocolState current;
     int expected;
-    int round;
 
-    int *order;
     int orderPos;
-    Card *cardsPlayed;
     int cardPos;
 
     int (*playerStrategy)();
+    const StrategyPlugin *plugin; // strategy playerStrategy asks, if any.
+    void *pluginState; // what the plugin's open returned.
+    CardHand seen; // every card played this game.
     int dPlayedRound;
     int *dPlayerNumber;
-    char *cardsFromRound;
-    char **cardsStored;
-    int largestPlayer;
-    int roundWinner;
+    Card *roundCards; // cards played this round, in the order played.
     int firstRound; // 0 if not, 1 if so.
     int lastPlayer;
+    int binary; // 1 if talking to the hub with the binary protocol.
+    int mux; // 1 if serving every table of a hub, see MUX_ENV.
+
+    Arena scratch; // copies made while decoding, reset after each message.
+    Arena storage; // storage sized by the player count, kept for every game.
+
+    int simulated; // 1 if moves are collected by the caller, not printed.
+    int moved; // set when a simulated player has chosen a card.
+    Card chosen; // card a simulated player chose.
 
 } PlayerGame;
 
@@ -82,42 +422,62 @@ void play_card(PlayerGame *game, Card *play);
 
 void save_card(PlayerGame *game, Card *card);
 
-int (*playerStrategy)(PlayerGame *game);
+extern int (*playerStrategy)(PlayerGame *game);
 
 int number_digits(int i);
 
 void player_end_of_round_output(PlayerGame *game);
 
-int check_expected(PlayerGame *game, char *got, int currentPlayer);
+MessageType message_type(const char *input);
 
-void set_expected(PlayerGame *game, char *set);
+int check_expected(PlayerGame *game, MessageType got, int currentPlayer);
 
-void init_expected(PlayerGame *game);
+void set_expected(PlayerGame *game, ProtocolState set);
 
-int get_rank_integer(char arg);
+int init_expected(PlayerGame *game);
 
-int card_in_lead_suit(PlayerGame *game);
+int init_game_storage(PlayerGame *game);
 
-Card lowest_in_suit(PlayerGame *game, char suit);
+void reset_expected(PlayerGame *game);
 
 void remove_card(PlayerGame *game, Card *card);
 
-void alice_default_move(PlayerGame *game);
-
 PlayerStatus show_player_message(PlayerStatus s);
 
+void use_plugin(PlayerGame *game, const StrategyPlugin *plugin);
+
+void release_plugin(PlayerGame *game);
+
+int plugin_move(PlayerGame *game);
+
+int run_player(int argc, char **argv, const StrategyPlugin *plugin);
+
 int decode_hand(char *input, PlayerGame *game);
 
 int decode_newround(char *input, PlayerGame *game);
 
+int apply_newround(PlayerGame *game, int leadPlayer);
+
 int decode_played(char *input, PlayerGame *game);
 
-int extract_last_player(char *input);
+int apply_played(PlayerGame *game, int justPlayed, Card newCard);
+
+int decode_newgame(char *input, PlayerGame *game);
+
+int apply_newgame(PlayerGame *game, int handSize);
+
+int extract_last_player(char *input, Arena *scratch);
 
 int process_input(char *input, PlayerGame *game);
 
+int process_record(int type, PlayerGame *game);
+
 int cont_read_stdin(PlayerGame *game);
 
+int cont_read_mux(PlayerGame *first);
+
+void send_ready(PlayerGame *game);
+
 int further_arg_checks(int argc, char **argv, PlayerGame *game);
 
 int parse_player(int argc, char **argv, PlayerGame *game);
@@ -0,0 +1,262 @@
+#define _GNU_SOURCE // memfd_create and fopencookie
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shmring.h"
+
+// struct for one end of a ring used as a stdio stream by a player
+typedef struct {
+    Ring *ring;
+    int spin;
+    pid_t hub; // the hub, which stops being our parent if it exits.
+} RingStream;
+
+/**
+ * Function to create and map the memory shared with one player.
+ * @param spin - times either side checks a ring before sleeping on it.
+ * @param fd - where to store the descriptor to pass to the player.
+ * @return the mapped link, NULL if it could not be created.
+ */
+ShmLink *shm_create(int spin, int *fd) {
+    *fd = memfd_create("2310hub", 0);
+    if (*fd < 0) {
+        return NULL;
+    }
+    ShmLink *link = NULL;
+    if (ftruncate(*fd, sizeof(ShmLink)) == 0) {
+        link = shm_attach(*fd);
+    }
+    if (!link) {
+        close(*fd);
+        return NULL;
+    }
+    // a new memfd is zeroed, so both rings start empty
+    link->spin = spin;
+    return link;
+}
+
+/**
+ * Function to map the memory the hub created for us.
+ * @param fd - descriptor passed by the hub.
+ * @return the mapped link, NULL if it could not be mapped.
+ */
+ShmLink *shm_attach(int fd) {
+    void *map = mmap(NULL, sizeof(ShmLink), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+/**
+ * Function to unmap a link.
+ * @param link - link to release, may be NULL.
+ */
+void shm_release(ShmLink *link) {
+    if (link) {
+        munmap(link, sizeof(ShmLink));
+    }
+}
+
+/**
+ * Function to wake whoever may be sleeping on a ring word.
+ * @param word - head or tail, just changed.
+ * @param waiting - flag saying the other side may be asleep on word.
+ */
+static void ring_wake(uint32_t *word, uint32_t *waiting) {
+    // pairs with the sequentially consistent store of waiting in ring_wait
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+/**
+ * Function to copy bytes into a ring without waiting, as many as fit.
+ * @param ring - ring to write to, only ever written by this process.
+ * @param bytes - bytes to write.
+ * @param length - number of bytes.
+ * @return number of bytes written.
+ */
+int ring_put(Ring *ring, const char *bytes, int length) {
+    uint32_t head = ring->head;
+    uint32_t space = RING_SIZE - (head - __atomic_load_n(&ring->tail,
+            __ATOMIC_ACQUIRE));
+    uint32_t count = (uint32_t) length < space ? (uint32_t) length : space;
+    uint32_t start = head & (RING_SIZE - 1);
+    uint32_t first = count < RING_SIZE - start ? count : RING_SIZE - start;
+    memcpy(ring->data + start, bytes, first);
+    memcpy(ring->data, bytes + first, count - first);
+    if (count > 0) {
+        __atomic_store_n(&ring->head, head + count, __ATOMIC_SEQ_CST);
+        ring_wake(&ring->head, &ring->readerWaiting);
+    }
+    return count;
+}
+
+/**
+ * Function to copy bytes out of a ring without waiting, as many as are there.
+ * @param ring - ring to read from, only ever read by this process.
+ * @param bytes - where to copy the bytes.
+ * @param size - room in bytes.
+ * @return number of bytes read.
+ */
+int ring_get(Ring *ring, char *bytes, int size) {
+    uint32_t tail = ring->tail;
+    uint32_t used = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t count = (uint32_t) size < used ? (uint32_t) size : used;
+    uint32_t start = tail & (RING_SIZE - 1);
+    uint32_t first = count < RING_SIZE - start ? count : RING_SIZE - start;
+    memcpy(bytes, ring->data + start, first);
+    memcpy(bytes + first, ring->data, count - first);
+    if (count > 0) {
+        __atomic_store_n(&ring->tail, tail + count, __ATOMIC_SEQ_CST);
+        ring_wake(&ring->tail, &ring->writerWaiting);
+    }
+    return count;
+}
+
+/**
+ * Function to check if a ring can be read from or written to.
+ * @param ring - ring to check.
+ * @param writable - 1 to check for space, 0 to check for bytes.
+ * @return 1 if it can, 0 if not.
+ */
+static int ring_ready(Ring *ring, int writable) {
+    uint32_t used = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)
+            - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    return writable ? used < RING_SIZE : used > 0;
+}
+
+/**
+ * Function to wait until a ring is ready, spinning first and then sleeping
+ * on the word the other side changes when it moves.
+ * @param ring - ring to wait on.
+ * @param writable - 1 to wait for space, 0 to wait for bytes.
+ * @param spin - times to check before sleeping.
+ * @param milliseconds - longest time to sleep.
+ * @return 1 if the ring is ready, 0 if the time ran out first.
+ */
+static int ring_wait(Ring *ring, int writable, int spin, int milliseconds) {
+    for (int i = 0; i < spin; i++) {
+        if (ring_ready(ring, writable)) {
+            return 1;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    uint32_t *word = writable ? &ring->tail : &ring->head;
+    uint32_t *waiting = writable ? &ring->writerWaiting : &ring->readerWaiting;
+    __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+    uint32_t seen = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+    if (!ring_ready(ring, writable)) {
+        // returns at once if word is no longer seen, so no wake is missed
+        struct timespec timeout = {milliseconds / 1000,
+                (milliseconds % 1000) * 1000000L};
+        syscall(SYS_futex, word, FUTEX_WAIT, seen, &timeout, NULL, 0);
+    }
+    __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+    return ring_ready(ring, writable);
+}
+
+/**
+ * Function to wait until a ring has bytes to read.
+ * @param ring - ring to wait on.
+ * @param spin - times to check before sleeping.
+ * @param milliseconds - longest time to sleep.
+ * @return 1 if there are bytes, 0 if the time ran out first.
+ */
+int ring_wait_readable(Ring *ring, int spin, int milliseconds) {
+    return ring_wait(ring, 0, spin, milliseconds);
+}
+
+/**
+ * Function to wait until a ring has space to write.
+ * @param ring - ring to wait on.
+ * @param spin - times to check before sleeping.
+ * @param milliseconds - longest time to sleep.
+ * @return 1 if there is space, 0 if the time ran out first.
+ */
+int ring_wait_writable(Ring *ring, int spin, int milliseconds) {
+    return ring_wait(ring, 1, spin, milliseconds);
+}
+
+/**
+ * Function to read a stream's ring for stdio, waiting for at least one byte.
+ * @param cookie - the RingStream.
+ * @param buffer - where to copy the bytes.
+ * @param size - room in bytes.
+ * @return number of bytes read, 0 (EOF) if the hub has gone.
+ */
+static ssize_t ring_stream_read(void *cookie, char *buffer, size_t size) {
+    RingStream *stream = cookie;
+    while (!ring_wait_readable(stream->ring, stream->spin, RING_SLICE_MS)) {
+        if (getppid() != stream->hub) {
+            return 0;
+        }
+    }
+    return ring_get(stream->ring, buffer, size < INT32_MAX ? size : INT32_MAX);
+}
+
+/**
+ * Function to write all of a buffer from stdio to a stream's ring.
+ * @param cookie - the RingStream.
+ * @param buffer - bytes to write.
+ * @param size - number of bytes.
+ * @return number of bytes written, -1 if the hub has gone.
+ */
+static ssize_t ring_stream_write(void *cookie, const char *buffer,
+        size_t size) {
+    RingStream *stream = cookie;
+    size_t written = 0;
+    while (written < size) {
+        int chunk = size - written < RING_SIZE ? size - written : RING_SIZE;
+        written += ring_put(stream->ring, buffer + written, chunk);
+        if (written < size && !ring_wait_writable(stream->ring, stream->spin,
+                RING_SLICE_MS) && getppid() != stream->hub) {
+            return -1;
+        }
+    }
+    return written;
+}
+
+/**
+ * Function to open one end of a link as a stdio stream.
+ * @param link - link the ring belongs to.
+ * @param ring - ring to read or write.
+ * @param mode - "r" or "w".
+ * @return the stream, NULL if it could not be opened.
+ */
+static FILE *ring_stream(ShmLink *link, Ring *ring, const char *mode) {
+    RingStream *stream = malloc(sizeof(RingStream));
+    stream->ring = ring;
+    stream->spin = link->spin;
+    stream->hub = getppid();
+    cookie_io_functions_t functions = {ring_stream_read, ring_stream_write,
+            NULL, NULL};
+    FILE *file = fopencookie(stream, mode, functions);
+    if (!file) {
+        free(stream);
+    }
+    return file;
+}
+
+/**
+ * Function to have a player's stdin and stdout use the rings of a link, so
+ * the rest of the player reads and writes them as it would its pipes.
+ * @param link - link offered by the hub.
+ * @return 1 if stdin and stdout now use the rings, 0 if they could not.
+ */
+int shm_use_stdio(ShmLink *link) {
+    FILE *input = ring_stream(link, &link->toPlayer, "r");
+    FILE *output = ring_stream(link, &link->fromPlayer, "w");
+    if (!input || !output) {
+        return 0;
+    }
+    // glibc's stdin and stdout are plain variables, the pipes stay open
+    stdin = input;
+    stdout = output;
+    return 1;
+}
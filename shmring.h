@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+/*
+ * Shared memory transport, offered by a hub started with --transport shm. The
+ * hub maps a ShmLink for each player and passes its file descriptor in the
+ * player's environment (HUB_SHM=fd). A player accepting it adds 'S' to its
+ * handshake and from then on reads and writes the rings instead of its pipes,
+ * which stay open so either side can tell the other has gone.
+ * Each ring has one writer and one reader. A side with nothing to do checks
+ * the ring up to spin times, then sleeps on a futex until the other side
+ * moves or RING_SLICE_MS passes, so it can check the other side is alive.
+ */
+#define SHM_ENV "HUB_SHM"
+
+// bytes in each ring, a power of two
+#define RING_SIZE 4096
+
+// longest sleep on a ring before checking the other side is still there
+#define RING_SLICE_MS 10
+
+// bytes in a cache line, the two ends of a ring never share one
+#define RING_CACHE_LINE 64
+
+// struct for a ring of bytes with one writer and one reader
+typedef struct {
+    // changed by the writer
+    uint32_t head __attribute__((aligned(RING_CACHE_LINE))); // bytes written.
+    uint32_t writerWaiting; // 1 while the writer may sleep on tail.
+    // changed by the reader
+    uint32_t tail __attribute__((aligned(RING_CACHE_LINE))); // bytes read.
+    uint32_t readerWaiting; // 1 while the reader may sleep on head.
+    char data[RING_SIZE] __attribute__((aligned(RING_CACHE_LINE)));
+} Ring;
+
+// struct for the memory shared by the hub and one player
+typedef struct {
+    Ring toPlayer;
+    Ring fromPlayer;
+    int spin; // times to check a ring before sleeping on it.
+} ShmLink;
+
+ShmLink *shm_create(int spin, int *fd);
+
+ShmLink *shm_attach(int fd);
+
+void shm_release(ShmLink *link);
+
+int ring_put(Ring *ring, const char *bytes, int length);
+
+int ring_get(Ring *ring, char *bytes, int size);
+
+int ring_wait_readable(Ring *ring, int spin, int milliseconds);
+
+int ring_wait_writable(Ring *ring, int spin, int milliseconds);
+
+int shm_use_stdio(ShmLink *link);
+
+#endif
@@ -0,0 +1,70 @@
+#include <stdint.h>
+
+#ifndef STRATEGY_ABI_H
+#define STRATEGY_ABI_H
+
+/*
+ * Strategy plug-ins: a shared object exporting STRATEGY_ENTRY, which returns
+ * the plug-in's StrategyPlugin. Players load them with 2310player, the hub
+ * runs a player argument ending in ".so" as a plug-in, and 2310sim takes one
+ * wherever it takes a strategy name. alice and bob are built both ways.
+ * A plug-in only sees the game through a StrategyView, and only needs this
+ * header. Each card has a code, suit index (S, C, D, H) * CARD_RANKS + rank,
+ * and sets of cards are CardSets with bit rank of word suit set for each
+ * card. A shoe may deal several copies of a card, which a CardSet holds once,
+ * so the copies beyond the first are counted by code alongside it.
+ * Plug-ins built for another STRATEGY_ABI_VERSION are refused.
+ */
+#define STRATEGY_ABI_VERSION 2
+
+// name of the function each plug-in exports
+#define STRATEGY_ENTRY "strategy_entry"
+
+// number of suits, ranks in each suit and card codes
+#define CARD_SUITS 4
+#define CARD_RANKS 64
+#define CARD_CODES (CARD_SUITS * CARD_RANKS)
+
+// set of cards as a bitboard, one word of rank bits for each suit
+typedef struct {
+    uint64_t suits[CARD_SUITS];
+} CardSet;
+
+// struct for what a strategy knows when it is its turn, read only
+typedef struct {
+    int playerCount;
+    int myID;
+    int threshold;
+    int handSize; // cards left in our hand, counting every copy.
+    CardSet hand; // cards in our hand.
+    const uint16_t *handCopies; // [code] copies in our hand beyond the first.
+    CardSet seen; // every card played this game before this move.
+    const uint16_t *seenCopies; // [code] copies seen beyond the first.
+    int leadPlayer; // player leading this round.
+    int leadSuit; // suit index of the lead card, -1 if we are leading.
+    int playedCount; // cards played this round before our move.
+    const uint8_t *played; // codes of those cards, in the order played.
+    // [player] D cards each other player has played this game. Our own
+    // entry stays 0, as the players have always counted it, so count our
+    // D cards from seen when they matter.
+    const int *dPlayed;
+    int dPlayedRound; // D cards played this round before our move.
+    void *state; // what the plug-in's open returned, NULL without one.
+} StrategyView;
+
+// struct describing a plug-in
+typedef struct {
+    uint32_t abiVersion; // STRATEGY_ABI_VERSION the plug-in was built for.
+    const char *name;
+    // called once for each seat the plug-in plays, may be NULL
+    void *(*open)(int playerCount, int myID, int threshold);
+    // called with what open returned once the seat is done, may be NULL
+    void (*close)(void *state);
+    // the code of the card to play, which must be in view->hand
+    int (*choose)(const StrategyView *view);
+} StrategyPlugin;
+
+// type of STRATEGY_ENTRY
+typedef const StrategyPlugin *(*StrategyEntry)(void);
+
+#endif
@@ -0,0 +1,12 @@
+#include "strategy_abi.h"
+
+// the plug-in this object is built into, named with -DSTRATEGY_PLUGIN=name
+extern const StrategyPlugin STRATEGY_PLUGIN;
+
+/**
+ * Function exported by a strategy plug-in, see STRATEGY_ENTRY.
+ * @return the plug-in.
+ */
+const StrategyPlugin *strategy_entry(void) {
+    return &STRATEGY_PLUGIN;
+}
@@ -0,0 +1,105 @@
+#include <time.h>
+#include "timing.h"
+
+/**
+ * Function to read the monotonic clock.
+ * @return the time in nanoseconds.
+ */
+uint64_t timing_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * Function to find the bucket of a duration. Small values get a bucket each,
+ * larger ones share a bucket with values of the same top three bits.
+ * @param nanoseconds - the duration.
+ * @return the bucket index.
+ */
+static int bucket_of(uint64_t nanoseconds) {
+    if (nanoseconds < (1 << TIMING_SUB_BITS)) {
+        return nanoseconds;
+    }
+    int top = 63 - __builtin_clzll(nanoseconds);
+    int sub = (nanoseconds >> (top - TIMING_SUB_BITS))
+            & ((1 << TIMING_SUB_BITS) - 1);
+    return ((top - TIMING_SUB_BITS + 1) << TIMING_SUB_BITS) + sub;
+}
+
+/**
+ * Function to find the smallest duration held by a bucket.
+ * @param bucket - the bucket index.
+ * @return the duration in nanoseconds.
+ */
+static uint64_t bucket_start(int bucket) {
+    if (bucket < (1 << TIMING_SUB_BITS)) {
+        return bucket;
+    }
+    int top = (bucket >> TIMING_SUB_BITS) + TIMING_SUB_BITS - 1;
+    uint64_t sub = bucket & ((1 << TIMING_SUB_BITS) - 1);
+    return ((1 << TIMING_SUB_BITS) + sub) << (top - TIMING_SUB_BITS);
+}
+
+/**
+ * Function to add a duration to a histogram.
+ * @param histogram - histogram to add to.
+ * @param nanoseconds - the duration.
+ */
+void histogram_record(Histogram *histogram, uint64_t nanoseconds) {
+    histogram->buckets[bucket_of(nanoseconds)]++;
+    histogram->count++;
+    if (nanoseconds > histogram->max) {
+        histogram->max = nanoseconds;
+    }
+}
+
+/**
+ * Function to add every duration in one histogram to another.
+ * @param into - histogram to add to.
+ * @param from - histogram to add.
+ */
+void histogram_merge(Histogram *into, const Histogram *from) {
+    for (int b = 0; b < TIMING_BUCKETS; b++) {
+        into->buckets[b] += from->buckets[b];
+    }
+    into->count += from->count;
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+/**
+ * Function to estimate a percentile of a histogram, as the top of the bucket
+ * it falls in (never more than the largest duration recorded).
+ * @param histogram - histogram to look in.
+ * @param percent - percentile wanted, 0 to 100.
+ * @return the duration in nanoseconds, 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(const Histogram *histogram, double percent) {
+    uint64_t wanted = histogram->count * percent / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < TIMING_BUCKETS; b++) {
+        seen += histogram->buckets[b];
+        if (seen > 0 && seen >= wanted) {
+            uint64_t top = b + 1 < TIMING_BUCKETS
+                    ? bucket_start(b + 1) - 1 : UINT64_MAX;
+            return top < histogram->max ? top : histogram->max;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function to print one line summarising a histogram in microseconds.
+ * @param output - stream to print to.
+ * @param label - name of what was timed.
+ * @param histogram - histogram to summarise.
+ */
+void histogram_print(FILE *output, const char *label,
+        const Histogram *histogram) {
+    fprintf(output, "%-10s %10llu %10.1f %10.1f %10.1f\n", label,
+            (unsigned long long) histogram->count,
+            histogram_percentile(histogram, 50) / 1e3,
+            histogram_percentile(histogram, 99) / 1e3, histogram->max / 1e3);
+}
@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#ifndef TIMING_H
+#define TIMING_H
+
+/*
+ * Log bucketed histograms of durations from the monotonic clock. Each power
+ * of two is split into four buckets, so a percentile is within 25% of the
+ * true value. Recording is a few instructions and never allocates.
+ */
+
+// sub buckets per power of two, as a shift
+#define TIMING_SUB_BITS 2
+
+// enough buckets for any 64 bit number of nanoseconds
+#define TIMING_BUCKETS (64 << TIMING_SUB_BITS)
+
+// struct for a histogram of durations in nanoseconds
+typedef struct {
+    uint64_t buckets[TIMING_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+} Histogram;
+
+uint64_t timing_now(void);
+
+void histogram_record(Histogram *histogram, uint64_t nanoseconds);
+
+void histogram_merge(Histogram *into, const Histogram *from);
+
+uint64_t histogram_percentile(const Histogram *histogram, double percent);
+
+void histogram_print(FILE *output, const char *label,
+        const Histogram *histogram);
+
+#endif